@@ -0,0 +1,257 @@
+// Size sweeps of the hot paths of Matrix, Polynomial, Rational and Permutation.
+// Every sweep fits a complexity curve, so a path that suddenly grows like n! shows up
+// in the BigO line. Machine-readable results:
+//   linal_bench --benchmark_out=results.json --benchmark_out_format=json
+// or --benchmark_format=json for JSON on stdout; --benchmark_filter=<regex> picks cases
+
+#include <benchmark/benchmark.h>
+
+#include "../linal.h"
+
+namespace {
+    // entries in [-range, range]: small enough that fractions and int do not overflow
+    template <typename T>
+    linal::Matrix<T> random_matrix(size_t n, size_t m, int range = 3, unsigned seed = 42) {
+        mt19937 rng(seed);
+        linal::Matrix<T> a(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                a[i][j] = T(int(rng() % (2 * range + 1)) - range);
+        return a;
+    }
+
+    // diagonally dominant, so inverse() never meets a singular matrix
+    template <typename T>
+    linal::Matrix<T> invertible_matrix(size_t n) {
+        linal::Matrix<T> a = random_matrix<T>(n, n, 1);
+        for (size_t i = 0; i != n; ++i)
+            a[i][i] = T(int(2 * n + 1));
+        return a;
+    }
+
+    template <typename T>
+    vector<T> random_vector(size_t n, int range = 100, unsigned seed = 7) {
+        mt19937 rng(seed);
+        vector<T> a(n);
+        for (T& x : a)
+            x = T(int(rng() % (2 * range + 1)) - range);
+        return a;
+    }
+
+    // runs f for every iteration, fixed-width scalars that overflow skip the case
+    template <typename F>
+    void run(benchmark::State& state, const F& f) {
+        try {
+            for (auto _ : state)
+                f();
+        } catch (const overflow_error& e) {
+            state.SkipWithError(e.what());
+            return;
+        }
+        state.SetComplexityN(state.range(0));
+    }
+
+    // Matrix
+
+    template <typename T>
+    void matrix_mul(benchmark::State& state) {
+        size_t n = state.range(0);
+        linal::Matrix<T> a = random_matrix<T>(n, n, 1, 1), b = random_matrix<T>(n, n, 1, 2);
+        run(state, [&] { benchmark::DoNotOptimize(a * b); });
+    }
+
+    template <typename T>
+    void matrix_det(benchmark::State& state) {
+        linal::Matrix<T> a = random_matrix<T>(state.range(0), state.range(0), 1);
+        run(state, [&] { benchmark::DoNotOptimize(a.det()); });
+    }
+
+    template <typename T>
+    void matrix_gauss(benchmark::State& state) {
+        linal::Matrix<T> a = random_matrix<T>(state.range(0), state.range(0) + 1);
+        run(state, [&] { benchmark::DoNotOptimize(a.gauss()); });
+    }
+
+    template <typename T>
+    void matrix_inverse(benchmark::State& state) {
+        linal::Matrix<T> a = invertible_matrix<T>(state.range(0));
+        run(state, [&] { benchmark::DoNotOptimize(a.inverse()); });
+    }
+
+    template <typename T>
+    void matrix_characteristic_polynomial(benchmark::State& state) {
+        linal::Matrix<T> a = random_matrix<T>(state.range(0), state.range(0), 1);
+        run(state, [&] { benchmark::DoNotOptimize(a.characteristic_polynomial()); });
+    }
+
+    // Polynomial
+
+    template <typename T>
+    void polynomial_mul(benchmark::State& state) {
+        size_t n = state.range(0);
+        Polynomial<T> p(random_vector<T>(n, 9, 1)), q(random_vector<T>(n, 9, 2));
+        run(state, [&] { benchmark::DoNotOptimize(p * q); });
+    }
+
+    // Rational: a dot product, one multiplication and one addition per term
+
+    template <typename R>
+    void rational_dot(benchmark::State& state) {
+        size_t n = state.range(0);
+        vector<R> x(n), y(n);
+        mt19937 rng(3);
+        for (size_t i = 0; i != n; ++i) {
+            x[i] = R(int(rng() % 19) - 9, int(rng() % 4) + 1);
+            y[i] = R(int(rng() % 19) - 9, int(rng() % 4) + 1);
+        }
+        run(state, [&] {
+            R sum = 0;
+            for (size_t i = 0; i != n; ++i)
+                sum += x[i] * y[i];
+            benchmark::DoNotOptimize(sum);
+        });
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    template <typename R>
+    void rational_div(benchmark::State& state) {
+        size_t n = state.range(0);
+        vector<R> x(n), y(n);
+        mt19937 rng(4);
+        for (size_t i = 0; i != n; ++i) {
+            x[i] = R(int(rng() % 1000) + 1, int(rng() % 1000) + 1);
+            y[i] = R(int(rng() % 1000) + 1, int(rng() % 1000) + 1);
+        }
+        run(state, [&] {
+            for (size_t i = 0; i != n; ++i)
+                benchmark::DoNotOptimize(x[i] / y[i]);
+        });
+        state.SetItemsProcessed(state.iterations() * n);
+    }
+
+    // Permutation
+
+    Permutation random_permutation(size_t n, unsigned seed) {
+        Permutation p(n);
+        mt19937 rng(seed);
+        for (size_t i = n; i > 1; --i)
+            swap(p[i - 1], p[rng() % i]);
+        return p;
+    }
+
+    void permutation_compose(benchmark::State& state) {
+        Permutation p = random_permutation(state.range(0), 1), q = random_permutation(state.range(0), 2);
+        run(state, [&] { benchmark::DoNotOptimize(p * q); });
+    }
+
+    // into a reused buffer
+    void permutation_compose_into(benchmark::State& state) {
+        Permutation p = random_permutation(state.range(0), 1), q = random_permutation(state.range(0), 2), ans(0);
+        run(state, [&] {
+            p.compose_into(q, ans);
+            benchmark::ClobberMemory();
+        });
+    }
+
+    void permutation_invert(benchmark::State& state) {
+        Permutation p = random_permutation(state.range(0), 5);
+        run(state, [&] {
+            p.invert();
+            benchmark::ClobberMemory();
+        });
+    }
+
+    // a large power, so it goes along the cycles
+    void permutation_power(benchmark::State& state) {
+        Permutation p = random_permutation(state.range(0), 3), ans(0);
+        run(state, [&] {
+            p.power_into(1000000007, ans);
+            benchmark::ClobberMemory();
+        });
+    }
+
+    void permutation_sign(benchmark::State& state) {
+        Permutation p = random_permutation(state.range(0), 4);
+        run(state, [&] { benchmark::DoNotOptimize(p.sign()); });
+    }
+
+    // all n! permutations in lexicographic order
+    void permutation_enumerate(benchmark::State& state) {
+        run(state, [&] {
+            Permutation p(state.range(0));
+            while (p.next_perm())
+                benchmark::ClobberMemory();
+        });
+    }
+
+    // all n! permutations in Heap's order, with their signs
+    void permutation_enumerate_heap(benchmark::State& state) {
+        run(state, [&] {
+            PermutationEnumerator e(state.range(0));
+            while (e.next())
+                benchmark::DoNotOptimize(e.sign());
+        });
+    }
+
+    // lines and then columns of an n x n matrix, in place along the cycles
+    template <typename T>
+    void matrix_permute(benchmark::State& state) {
+        size_t n = state.range(0);
+        linal::Matrix<T> a = random_matrix<T>(n, n);
+        Permutation p = random_permutation(n, 6);
+        run(state, [&] {
+            a.permute_rows(p);
+            a.permute_cols(p);
+            benchmark::ClobberMemory();
+        });
+    }
+}
+
+#define LINAL_SWEEP(f, T, from, to, step) \
+    BENCHMARK_TEMPLATE(f, T)->RangeMultiplier(step)->Range(from, to)->Complexity()
+
+LINAL_SWEEP(matrix_mul, int, 16, 256, 2);
+LINAL_SWEEP(matrix_mul, double, 16, 256, 2);
+LINAL_SWEEP(matrix_mul, Rational64, 8, 64, 2);
+LINAL_SWEEP(matrix_mul, BigRational, 8, 32, 2);
+
+LINAL_SWEEP(matrix_det, int, 4, 16, 2);
+LINAL_SWEEP(matrix_det, double, 16, 256, 2);
+LINAL_SWEEP(matrix_det, Rational64, 4, 16, 2);
+LINAL_SWEEP(matrix_det, BigRational, 4, 32, 2);
+
+LINAL_SWEEP(matrix_gauss, double, 16, 256, 2);
+LINAL_SWEEP(matrix_gauss, Rational64, 4, 16, 2);
+LINAL_SWEEP(matrix_gauss, BigRational, 4, 32, 2);
+
+LINAL_SWEEP(matrix_inverse, double, 16, 256, 2);
+LINAL_SWEEP(matrix_inverse, Rational64, 4, 8, 2);
+LINAL_SWEEP(matrix_inverse, BigRational, 4, 32, 2);
+
+LINAL_SWEEP(matrix_characteristic_polynomial, int, 4, 16, 2);
+LINAL_SWEEP(matrix_characteristic_polynomial, double, 16, 128, 2);
+LINAL_SWEEP(matrix_characteristic_polynomial, Rational64, 4, 16, 2);
+LINAL_SWEEP(matrix_characteristic_polynomial, BigRational, 4, 16, 2);
+
+LINAL_SWEEP(polynomial_mul, int, 16, 16384, 4);
+LINAL_SWEEP(polynomial_mul, double, 16, 16384, 4);
+LINAL_SWEEP(polynomial_mul, Rational64, 16, 1024, 4);
+
+LINAL_SWEEP(rational_dot, Rational64, 64, 4096, 4);
+LINAL_SWEEP(rational_dot, LazyRational64, 64, 4096, 4);
+LINAL_SWEEP(rational_dot, BigRational, 64, 4096, 4);
+LINAL_SWEEP(rational_div, Rational64, 64, 4096, 4);
+LINAL_SWEEP(rational_div, BigRational, 64, 4096, 4);
+
+LINAL_SWEEP(matrix_permute, double, 64, 2048, 2);
+LINAL_SWEEP(matrix_permute, Rational64, 64, 1024, 2);
+
+BENCHMARK(permutation_compose)->RangeMultiplier(8)->Range(1 << 10, 1 << 23)->Complexity(benchmark::oN);
+BENCHMARK(permutation_compose_into)->RangeMultiplier(8)->Range(1 << 10, 1 << 23)->Complexity(benchmark::oN);
+BENCHMARK(permutation_invert)->RangeMultiplier(8)->Range(1 << 10, 1 << 23)->Complexity(benchmark::oN);
+BENCHMARK(permutation_power)->RangeMultiplier(8)->Range(1 << 10, 1 << 23)->Complexity(benchmark::oN);
+BENCHMARK(permutation_sign)->RangeMultiplier(4)->Range(1 << 6, 1 << 12)->Complexity();
+BENCHMARK(permutation_enumerate)->DenseRange(6, 10, 1);
+BENCHMARK(permutation_enumerate_heap)->DenseRange(6, 10, 1);
+
+BENCHMARK_MAIN();
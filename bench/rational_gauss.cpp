@@ -0,0 +1,57 @@
+// Effect of the gcd kernel and of lazy normalization on Matrix::gauss().
+// g++ -O2 -std=c++17 -pthread bench/rational_gauss.cpp -o rational_gauss
+
+#include "../linal.h"
+
+template <typename F>
+double seconds(size_t reps, const F& f) {
+    auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i != reps; ++i)
+        f();
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count() / reps;
+}
+
+template <typename R>
+linal::Matrix<R> random_matrix(size_t n, size_t m, unsigned seed) {
+    mt19937 rng(seed);
+    linal::Matrix<R> a(n, m);
+    for (size_t i = 0; i != n; ++i)
+        for (size_t j = 0; j != m; ++j)
+            a[i][j] = R(int(rng() % 7) - 3);
+    return a;
+}
+
+template <typename R>
+void gauss_row(const char* name, size_t n) {
+    linal::Matrix<R> a = random_matrix<R>(n, n + 1, 42);
+    size_t reps = max<size_t>(1, 2000 / (n * n));
+    double t = seconds(reps, [&] { volatile size_t sink = a.gauss().size().first; (void)sink; });
+    cout << name << "\tn = " << n << "\t" << t * 1e6 << " us\n";
+}
+
+template <typename Int>
+void gcd_row(const char* name, int bits) {
+    mt19937_64 rng(1);
+    vector<Int> x(1 << 14), y(1 << 14);
+    for (size_t i = 0; i != x.size(); ++i) {
+        x[i] = Int((unsigned __int128)rng() << 64 | rng()) & ((Int(1) << bits) - 1);
+        y[i] = Int((unsigned __int128)rng() << 64 | rng()) & ((Int(1) << bits) - 1);
+    }
+    Int sink = 0;
+    double euclid = seconds(20, [&] { for (size_t i = 0; i != x.size(); ++i) sink += gcd_euclid(x[i], y[i]); });
+    double kernel = seconds(20, [&] { for (size_t i = 0; i != x.size(); ++i) sink += gcd_kernel(x[i], y[i]); });
+    cout << "gcd " << name << "\teuclid " << euclid / x.size() * 1e9 << " ns\tgcd_kernel "
+         << kernel / x.size() * 1e9 << " ns\t(" << int(sink % 2) << ")\n";
+}
+
+int main() {
+    gcd_row<int>("int, 30 bits", 30);
+    gcd_row<int64_t>("int64_t, 62 bits", 62);
+    gcd_row<__int128>("__int128, 126 bits", 126);
+
+    for (size_t n : {4, 8, 12}) {
+        gauss_row<Rational64>("Rational64", n);
+        gauss_row<LazyRational64>("LazyRational64", n);
+        gauss_row<BigRational>("BigRational", n);
+    }
+}
@@ -0,0 +1,322 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Arbitrary-precision integer for exact arithmetic that must not overflow.
+// Sign and magnitude, the magnitude is stored in 32-bit limbs, lowest first.
+// Division truncates towards zero, like the built-in types do.
+class BigInt {
+  private:
+    bool negative = false;
+    std::vector<uint32_t> mag;      // no leading zero limbs, empty for 0
+
+    void trim() {
+        while (!mag.empty() && mag.back() == 0)
+            mag.pop_back();
+        if (mag.empty())
+            negative = false;
+    }
+
+    static int compare_mag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        if (a.size() != b.size())
+            return a.size() < b.size() ? -1 : 1;
+        for (size_t i = a.size(); i-- != 0;)
+            if (a[i] != b[i])
+                return a[i] < b[i] ? -1 : 1;
+        return 0;
+    }
+
+    static std::vector<uint32_t> add_mag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        const std::vector<uint32_t>& x = a.size() >= b.size() ? a : b;
+        const std::vector<uint32_t>& y = a.size() >= b.size() ? b : a;
+        std::vector<uint32_t> ans(x.size() + 1);
+        uint64_t carry = 0;
+        for (size_t i = 0; i != x.size(); ++i) {
+            carry += uint64_t(x[i]) + (i < y.size() ? y[i] : 0);
+            ans[i] = uint32_t(carry);
+            carry >>= 32;
+        }
+        ans[x.size()] = uint32_t(carry);
+        return ans;
+    }
+
+    // |a| >= |b|
+    static std::vector<uint32_t> sub_mag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        std::vector<uint32_t> ans(a.size());
+        int64_t borrow = 0;
+        for (size_t i = 0; i != a.size(); ++i) {
+            int64_t cur = int64_t(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+            borrow = cur < 0;
+            ans[i] = uint32_t(cur + (borrow << 32));
+        }
+        return ans;
+    }
+
+    static std::vector<uint32_t> mul_mag(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+        if (a.empty() || b.empty())
+            return {};
+        std::vector<uint32_t> ans(a.size() + b.size());
+        for (size_t i = 0; i != a.size(); ++i) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j != b.size(); ++j) {
+                carry += uint64_t(a[i]) * b[j] + ans[i + j];
+                ans[i + j] = uint32_t(carry);
+                carry >>= 32;
+            }
+            ans[i + b.size()] = uint32_t(carry);
+        }
+        return ans;
+    }
+
+    // Knuth's algorithm D, |u| / |v| = q, |u| % |v| = r, v is not 0
+    static void divmod_mag(const std::vector<uint32_t>& u, const std::vector<uint32_t>& v,
+                           std::vector<uint32_t>& q, std::vector<uint32_t>& r) {
+        if (compare_mag(u, v) < 0) {
+            q.clear();
+            r = u;
+            return;
+        }
+        size_t n = v.size(), m = u.size() - n;
+        if (n == 1) {
+            q.assign(u.size(), 0);
+            uint64_t rem = 0;
+            for (size_t i = u.size(); i-- != 0;) {
+                uint64_t cur = (rem << 32) | u[i];
+                q[i] = uint32_t(cur / v[0]);
+                rem = cur % v[0];
+            }
+            r.assign(1, uint32_t(rem));
+            return;
+        }
+        int s = __builtin_clz(v.back());
+        std::vector<uint32_t> vn(n), un(u.size() + 1);
+        for (size_t i = n - 1; i != 0; --i)
+            vn[i] = (v[i] << s) | (s ? uint32_t(uint64_t(v[i - 1]) >> (32 - s)) : 0);
+        vn[0] = v[0] << s;
+        un[u.size()] = s ? uint32_t(uint64_t(u.back()) >> (32 - s)) : 0;
+        for (size_t i = u.size() - 1; i != 0; --i)
+            un[i] = (u[i] << s) | (s ? uint32_t(uint64_t(u[i - 1]) >> (32 - s)) : 0);
+        un[0] = u[0] << s;
+        q.assign(m + 1, 0);
+        const uint64_t base = uint64_t(1) << 32;
+        for (size_t j = m + 1; j-- != 0;) {
+            uint64_t num = (uint64_t(un[j + n]) << 32) | un[j + n - 1];
+            uint64_t qhat = num / vn[n - 1], rhat = num % vn[n - 1];
+            while (qhat >= base || qhat * vn[n - 2] > ((rhat << 32) | un[j + n - 2])) {
+                --qhat;
+                rhat += vn[n - 1];
+                if (rhat >= base)
+                    break;
+            }
+            int64_t k = 0, t;
+            for (size_t i = 0; i != n; ++i) {
+                uint64_t p = qhat * vn[i];
+                t = int64_t(un[i + j]) - k - int64_t(p & 0xFFFFFFFFu);
+                un[i + j] = uint32_t(t);
+                k = int64_t(p >> 32) - (t >> 32);
+            }
+            t = int64_t(un[j + n]) - k;
+            un[j + n] = uint32_t(t);
+            q[j] = uint32_t(qhat);
+            if (t < 0) {
+                --q[j];
+                uint64_t carry = 0;
+                for (size_t i = 0; i != n; ++i) {
+                    carry += uint64_t(un[i + j]) + vn[i];
+                    un[i + j] = uint32_t(carry);
+                    carry >>= 32;
+                }
+                un[j + n] += uint32_t(carry);
+            }
+        }
+        r.assign(n, 0);
+        for (size_t i = 0; i != n; ++i)
+            r[i] = (un[i] >> s) | (s ? uint32_t(uint64_t(un[i + 1]) << (32 - s)) : 0);
+    }
+
+  public:
+    // constructors
+
+    BigInt() {}
+
+    template<typename I, typename = typename std::enable_if<std::is_integral<I>::value ||
+                                                            std::is_same<I, __int128>::value>::type>
+    BigInt(I x) {
+        negative = x < 0;
+        unsigned __int128 v = negative ? -static_cast<unsigned __int128>(x) : static_cast<unsigned __int128>(x);
+        for (; v != 0; v >>= 32)
+            mag.push_back(uint32_t(v));
+    }
+
+    explicit BigInt(const std::string& s) {
+        size_t i = s.size() && (s[0] == '-' || s[0] == '+');
+        for (; i != s.size(); ++i)
+            *this = *this * 10 + (s[i] - '0');
+        negative = !s.empty() && s[0] == '-' && !mag.empty();
+    }
+
+    bool is_negative() const {
+        return negative;
+    }
+
+    bool is_zero() const {
+        return mag.empty();
+    }
+
+    size_t bit_length() const {
+        return mag.empty() ? 0 : 32 * mag.size() - __builtin_clz(mag.back());
+    }
+
+    explicit operator long long() const {
+        unsigned long long v = 0;
+        for (size_t i = std::min<size_t>(mag.size(), 2); i-- != 0;)
+            v = (v << 32) | mag[i];
+        return negative ? -static_cast<long long>(v) : static_cast<long long>(v);
+    }
+
+    explicit operator double() const {
+        double ans = 0;
+        for (size_t i = mag.size(); i-- != 0;)
+            ans = ans * 4294967296.0 + mag[i];
+        return negative ? -ans : ans;
+    }
+
+    std::string to_string() const {
+        if (mag.empty())
+            return "0";
+        std::string ans;
+        std::vector<uint32_t> cur = mag, q, r;
+        const std::vector<uint32_t> chunk = {1000000000u};
+        while (!cur.empty()) {
+            divmod_mag(cur, chunk, q, r);
+            uint32_t digits = r.empty() ? 0 : r[0];
+            while (!q.empty() && q.back() == 0)
+                q.pop_back();
+            for (int i = 0; i != 9 && (!q.empty() || digits != 0); ++i, digits /= 10)
+                ans += char('0' + digits % 10);
+            cur.swap(q);
+        }
+        if (negative)
+            ans += '-';
+        std::reverse(ans.begin(), ans.end());
+        return ans;
+    }
+
+    // operators
+
+    BigInt operator-() const {
+        BigInt ans = *this;
+        if (!ans.mag.empty())
+            ans.negative = !negative;
+        return ans;
+    }
+
+    friend BigInt operator+(const BigInt& a, const BigInt& b) {
+        BigInt ans;
+        if (a.negative == b.negative) {
+            ans.mag = add_mag(a.mag, b.mag);
+            ans.negative = a.negative;
+        } else if (compare_mag(a.mag, b.mag) >= 0) {
+            ans.mag = sub_mag(a.mag, b.mag);
+            ans.negative = a.negative;
+        } else {
+            ans.mag = sub_mag(b.mag, a.mag);
+            ans.negative = b.negative;
+        }
+        ans.trim();
+        return ans;
+    }
+
+    friend BigInt operator-(const BigInt& a, const BigInt& b) {
+        return a + (-b);
+    }
+
+    friend BigInt operator*(const BigInt& a, const BigInt& b) {
+        BigInt ans;
+        ans.mag = mul_mag(a.mag, b.mag);
+        ans.negative = a.negative != b.negative;
+        ans.trim();
+        return ans;
+    }
+
+    friend BigInt operator/(const BigInt& a, const BigInt& b) {
+        if (b.mag.empty())
+            throw std::domain_error("BigInt: division by zero");
+        BigInt q, r;
+        divmod_mag(a.mag, b.mag, q.mag, r.mag);
+        q.negative = a.negative != b.negative;
+        q.trim();
+        return q;
+    }
+
+    friend BigInt operator%(const BigInt& a, const BigInt& b) {
+        if (b.mag.empty())
+            throw std::domain_error("BigInt: division by zero");
+        BigInt q, r;
+        divmod_mag(a.mag, b.mag, q.mag, r.mag);
+        r.negative = a.negative;
+        r.trim();
+        return r;
+    }
+
+    friend BigInt& operator+=(BigInt& a, const BigInt& b) {
+        return a = a + b;
+    }
+
+    friend BigInt& operator-=(BigInt& a, const BigInt& b) {
+        return a = a - b;
+    }
+
+    friend BigInt& operator*=(BigInt& a, const BigInt& b) {
+        return a = a * b;
+    }
+
+    friend BigInt& operator/=(BigInt& a, const BigInt& b) {
+        return a = a / b;
+    }
+
+    friend BigInt& operator%=(BigInt& a, const BigInt& b) {
+        return a = a % b;
+    }
+
+    friend bool operator==(const BigInt& a, const BigInt& b) {
+        return a.negative == b.negative && a.mag == b.mag;
+    }
+
+    friend bool operator!=(const BigInt& a, const BigInt& b) {
+        return !(a == b);
+    }
+
+    friend bool operator<(const BigInt& a, const BigInt& b) {
+        if (a.negative != b.negative)
+            return a.negative;
+        int c = compare_mag(a.mag, b.mag);
+        return a.negative ? c > 0 : c < 0;
+    }
+
+    friend bool operator>(const BigInt& a, const BigInt& b) {
+        return b < a;
+    }
+
+    friend bool operator<=(const BigInt& a, const BigInt& b) {
+        return !(b < a);
+    }
+
+    friend bool operator>=(const BigInt& a, const BigInt& b) {
+        return !(a < b);
+    }
+};
+
+inline BigInt abs(const BigInt& a) {
+    return a.is_negative() ? -a : a;
+}
+
+inline std::ostream& operator<<(std::ostream& out, const BigInt& a) {
+    return out << a.to_string();
+}
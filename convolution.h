@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "modint.h"
+
+// Products of coefficient vectors for Polynomial.
+// Short factors use the schoolbook loop, medium ones Karatsuba, long ones a number
+// theoretic transform when the scalars allow an exact one: residues modulo a prime,
+// or integers whose product fits under three NTT primes and is put back by CRT
+namespace convolution {
+    const size_t schoolbook_limit = 32;     // shorter factors are multiplied directly
+    const size_t transform_limit = 128;     // shorter factors go to Karatsuba
+
+    template<typename T>
+    struct is_mod_int : std::false_type {};
+
+    template<uint32_t P>
+    struct is_mod_int<ModInt<P>> : std::true_type {};
+
+    // ans[i + j] += a[i] * b[j]
+    template<typename T>
+    void schoolbook(const T* a, size_t n, const T* b, size_t m, T* ans) {
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                ans[i + j] += a[i] * b[j];
+    }
+
+    // ans[0 .. n + m - 1) += a * b, three half-size products instead of four
+    template<typename T>
+    void karatsuba(const T* a, size_t n, const T* b, size_t m, T* ans) {
+        if (n < m) {
+            std::swap(a, b);
+            std::swap(n, m);
+        }
+        if (m < schoolbook_limit) {
+            schoolbook(a, n, b, m, ans);
+            return;
+        }
+        if (n != m) {       // unbalanced: a is cut into pieces as long as b
+            for (size_t i = 0; i < n; i += m)
+                karatsuba(a + i, std::min(m, n - i), b, m, ans + i);
+            return;
+        }
+        // a = a0 + x^h a1, b = b0 + x^h b1, a1 and b1 are not shorter than a0 and b0
+        size_t h = n / 2, k = n - h;
+        const T zero = static_cast<T>(0);
+        std::vector<T> sa(a + h, a + n), sb(b + h, b + n);
+        for (size_t i = 0; i != h; ++i) {
+            sa[i] += a[i];
+            sb[i] += b[i];
+        }
+        std::vector<T> low(2 * h - 1, zero), high(2 * k - 1, zero), mid(2 * k - 1, zero);
+        karatsuba(a, h, b, h, low.data());
+        karatsuba(a + h, k, b + h, k, high.data());
+        karatsuba(sa.data(), k, sb.data(), k, mid.data());
+        for (size_t i = 0; i != low.size(); ++i) {
+            ans[i] += low[i];
+            mid[i] -= low[i];
+        }
+        for (size_t i = 0; i != high.size(); ++i) {
+            ans[i + 2 * h] += high[i];
+            mid[i] -= high[i];
+        }
+        for (size_t i = 0; i != mid.size(); ++i)
+            ans[i + h] += mid[i];
+    }
+
+    inline uint64_t pow_mod(uint64_t a, uint64_t k, uint32_t p) {
+        uint64_t ans = 1;
+        for (a %= p; k != 0; k >>= 1, a = a * a % p)
+            if (k & 1)
+                ans = ans * a % p;
+        return ans;
+    }
+
+    // the smallest generator of the multiplicative group modulo a prime p
+    inline uint32_t primitive_root(uint32_t p) {
+        std::vector<uint32_t> factors;
+        uint32_t x = p - 1;
+        for (uint32_t d = 2; d * d <= x; ++d)
+            if (x % d == 0) {
+                factors.push_back(d);
+                while (x % d == 0)
+                    x /= d;
+            }
+        if (x > 1)
+            factors.push_back(x);
+        for (uint32_t g = 2;; ++g) {
+            bool generator = true;
+            for (size_t i = 0; i != factors.size() && generator; ++i)
+                generator = pow_mod(g, (p - 1) / factors[i], p) != 1;
+            if (generator)
+                return g;
+        }
+    }
+
+    // the longest transform modulo p: the largest power of two dividing p - 1
+    inline size_t max_transform(uint32_t p) {
+        return size_t(1) << __builtin_ctz(p - 1);
+    }
+
+    // in-place transform of Montgomery residues, a.size() is a power of two dividing p - 1
+    inline void ntt(std::vector<uint32_t>& a, const Montgomery& mg, uint32_t root, bool invert) {
+        size_t n = a.size();
+        for (size_t i = 1, j = 0; i < n; ++i) {
+            size_t bit = n >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+            if (i < j)
+                std::swap(a[i], a[j]);
+        }
+        std::vector<uint32_t> w(n / 2);
+        for (size_t len = 2; len <= n; len <<= 1) {
+            uint32_t step = mg.pow(mg.to(root), (mg.mod - 1) / len);
+            if (invert)
+                step = mg.inverse(step);
+            size_t half = len / 2;
+            w[0] = mg.one();
+            for (size_t j = 1; j != half; ++j)
+                w[j] = mg.mul(w[j - 1], step);
+            for (size_t i = 0; i != n; i += len)
+                for (size_t j = 0; j != half; ++j) {
+                    uint32_t u = a[i + j], v = mg.mul(a[i + j + half], w[j]);
+                    a[i + j] = mg.add(u, v);
+                    a[i + j + half] = mg.sub(u, v);
+                }
+        }
+        if (invert) {
+            uint32_t scale = mg.inverse(mg.to(uint32_t(n % mg.mod)));
+            for (uint32_t& x : a)
+                x = mg.mul(x, scale);
+        }
+    }
+
+    // a * b modulo p for residues in [0, p); the product has to fit in max_transform(p)
+    inline std::vector<uint32_t> ntt_multiply(std::vector<uint32_t> a, std::vector<uint32_t> b, uint32_t p) {
+        size_t len = a.size() + b.size() - 1, n = 1;
+        while (n < len)
+            n <<= 1;
+        Montgomery mg(p);
+        uint32_t root = primitive_root(p);
+        a.resize(n), b.resize(n);
+        for (size_t i = 0; i != n; ++i) {
+            a[i] = mg.to(a[i] % p);
+            b[i] = mg.to(b[i] % p);
+        }
+        ntt(a, mg, root, false);
+        ntt(b, mg, root, false);
+        for (size_t i = 0; i != n; ++i)
+            a[i] = mg.mul(a[i], b[i]);
+        ntt(a, mg, root, true);
+        a.resize(len);
+        for (uint32_t& x : a)
+            x = mg.from(x);
+        return a;
+    }
+
+    // three primes with transforms of length up to 2^23, product about 2^86
+    const uint32_t crt_primes[3] = {998244353, 167772161, 469762049};
+
+    inline size_t crt_max_transform() {
+        return std::min({max_transform(crt_primes[0]), max_transform(crt_primes[1]), max_transform(crt_primes[2])});
+    }
+
+    // Garner: the x in [0, p0 p1 p2) with the given residues
+    inline unsigned __int128 crt(uint32_t r0, uint32_t r1, uint32_t r2) {
+        const uint64_t p0 = crt_primes[0], p1 = crt_primes[1], p2 = crt_primes[2];
+        static const uint64_t inv01 = pow_mod(p0, p1 - 2, p1), inv012 = pow_mod(p0 * p1 % p2, p2 - 2, p2);
+        uint64_t v1 = (r1 + p1 - r0 % p1) % p1 * inv01 % p1;
+        uint64_t x01 = r0 + p0 * v1;      // < p0 p1 < 2^58
+        uint64_t v2 = (r2 + p2 - x01 % p2) % p2 * inv012 % p2;
+        return x01 + static_cast<unsigned __int128>(p0 * p1) * v2;
+    }
+
+    // the product of residue vectors, by one transform if P allows it, by three primes otherwise
+    template<uint32_t P>
+    std::vector<ModInt<P>> mod_multiply(const std::vector<ModInt<P>>& a, const std::vector<ModInt<P>>& b) {
+        std::vector<uint32_t> x(a.size()), y(b.size());
+        for (size_t i = 0; i != a.size(); ++i)
+            x[i] = a[i].value();
+        for (size_t i = 0; i != b.size(); ++i)
+            y[i] = b[i].value();
+        size_t len = a.size() + b.size() - 1;
+        std::vector<ModInt<P>> ans(len);
+        if (len <= max_transform(P)) {
+            std::vector<uint32_t> z = ntt_multiply(x, y, P);
+            for (size_t i = 0; i != len; ++i)
+                ans[i] = ModInt<P>(z[i]);
+            return ans;
+        }
+        std::vector<uint32_t> z[3];
+        for (int t = 0; t != 3; ++t)
+            z[t] = ntt_multiply(x, y, crt_primes[t]);
+        for (size_t i = 0; i != len; ++i)
+            ans[i] = ModInt<P>(static_cast<long long>(crt(z[0][i], z[1][i], z[2][i]) % P));
+        return ans;
+    }
+
+    // exact product of integers by three primes, false if it may not fit under their product
+    template<typename T>
+    bool integral_multiply(const std::vector<T>& a, const std::vector<T>& b, std::vector<T>& ans) {
+        auto largest = [](const std::vector<T>& v) {
+            long double ans = 0;
+            for (const T& x : v)
+                ans = std::max(ans, std::fabs(static_cast<long double>(x)));
+            return ans;
+        };
+        long double bound = largest(a) * largest(b) * std::min(a.size(), b.size());
+        if (bound >= std::ldexp(1.0L, 84))
+            return false;
+        std::vector<uint32_t> z[3];
+        for (int t = 0; t != 3; ++t) {
+            uint32_t p = crt_primes[t];
+            std::vector<uint32_t> x(a.size()), y(b.size());
+            for (size_t i = 0; i != a.size(); ++i)
+                x[i] = uint32_t((static_cast<__int128>(a[i]) % p + p) % p);
+            for (size_t i = 0; i != b.size(); ++i)
+                y[i] = uint32_t((static_cast<__int128>(b[i]) % p + p) % p);
+            z[t] = ntt_multiply(x, y, p);
+        }
+        const __int128 product = static_cast<__int128>(uint64_t(crt_primes[0]) * crt_primes[1]) * crt_primes[2];
+        ans.resize(a.size() + b.size() - 1);
+        for (size_t i = 0; i != ans.size(); ++i) {
+            __int128 x = static_cast<__int128>(crt(z[0][i], z[1][i], z[2][i]));
+            ans[i] = static_cast<T>(x > product / 2 ? x - product : x);
+        }
+        return true;
+    }
+
+    // a * b, the method is chosen by length and scalar type
+    template<typename T>
+    std::vector<T> multiply(const std::vector<T>& a, const std::vector<T>& b) {
+        if (a.empty() || b.empty())
+            return {};
+        size_t shorter = std::min(a.size(), b.size()), len = a.size() + b.size() - 1;
+        if (shorter >= transform_limit) {
+            if constexpr (is_mod_int<T>::value) {
+                if (len <= crt_max_transform() || len <= max_transform(T::modulus()))
+                    return mod_multiply(a, b);
+            } else if constexpr (std::is_integral<T>::value && sizeof(T) <= 8) {
+                std::vector<T> ans;
+                if (len <= crt_max_transform() && integral_multiply(a, b, ans))
+                    return ans;
+            }
+        }
+        std::vector<T> ans(len, static_cast<T>(0));
+        karatsuba(a.data(), a.size(), b.data(), b.size(), ans.data());
+        return ans;
+    }
+}
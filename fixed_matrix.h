@@ -0,0 +1,299 @@
+#pragma once
+
+// Matrices with sizes known at compile time: the entries live inside the object, loops
+// have constant bounds, small products are unrolled and determinants and inverses up
+// to 4 x 4 are written out, so transforms need no heap and no branches on the size.
+// Everything is constexpr for literal T. Matrix<T, N> is N x N; anything else is
+// available through the conversion to Matrix<T>
+
+namespace linal {
+    template <typename T, int N, int M>
+    class Matrix {
+        static_assert(N > 0 && M > 0, "linal::Matrix: sizes are positive, or both dynamic");
+
+      private:
+        T a[N * M];     // row-major, element (i, j) is a[i * M + j]
+
+        template <typename, int, int>
+        friend class Matrix;
+
+        // products with at most this many multiplications are unrolled
+        static const int unroll_limit = 64;
+
+        template <int P, size_t... K>
+        constexpr T dot(int i, const Matrix<T, M, P>& b, int j, index_sequence<K...>) const {
+            return (... + (a[i * M + K] * b.a[K * P + j]));
+        }
+
+        template <int P, size_t... I>
+        constexpr Matrix<T, N, P> unrolled_product(const Matrix<T, M, P>& b, index_sequence<I...>) const {
+            Matrix<T, N, P> ans;
+            ((ans.a[I] = dot(I / P, b, I % P, make_index_sequence<M>())), ...);
+            return ans;
+        }
+
+        static constexpr Matrix identity() {
+            Matrix ans;
+            for (int i = 0; i != N; ++i)
+                ans.a[i * M + i] = static_cast<T>(1);
+            return ans;
+        }
+
+        // 4 x 4: the 2 x 2 minors of lines 0, 1 (s) and of lines 2, 3 (c),
+        // both on columns (0, 1), (0, 2), (0, 3), (1, 2), (1, 3), (2, 3)
+        constexpr void minors(T* s, T* c) const {
+            const int cols[6][2] = {{0, 1}, {0, 2}, {0, 3}, {1, 2}, {1, 3}, {2, 3}};
+            for (int k = 0; k != 6; ++k) {
+                int x = cols[k][0], y = cols[k][1];
+                s[k] = a[x] * a[4 + y] - a[4 + x] * a[y];
+                c[k] = a[8 + x] * a[12 + y] - a[12 + x] * a[8 + y];
+            }
+        }
+
+      public:
+        // zero matrix
+        constexpr Matrix() : a() {}
+
+        // Matrix<T, 2>{{a, b}, {c, d}}
+        constexpr Matrix(initializer_list<initializer_list<T>> lines) : a() {
+            if (lines.size() != N)
+                throw invalid_argument("linal::Matrix: wrong number of lines");
+            int i = 0;
+            for (const initializer_list<T>& line : lines) {
+                if (line.size() != M)
+                    throw invalid_argument("linal::Matrix: wrong number of columns");
+                int j = 0;
+                for (const T& x : line)
+                    a[i * M + j++] = x;
+                ++i;
+            }
+        }
+
+        explicit Matrix(const Matrix<T>& other) : a() {
+            if (other.size() != size())
+                throw invalid_argument("linal::Matrix: sizes do not match");
+            for (int i = 0; i != N; ++i)
+                for (int j = 0; j != M; ++j)
+                    a[i * M + j] = other[i][j];
+        }
+
+        operator Matrix<T>() const {
+            Matrix<T> ans(N, M);
+            for (int i = 0; i != N; ++i)
+                for (int j = 0; j != M; ++j)
+                    ans[i][j] = a[i * M + j];
+            return ans;
+        }
+
+        // {lines, columns}
+        constexpr pair<int, int> size() const {
+            return {N, M};
+        }
+
+        // operators
+
+        constexpr T* operator[](int i) {
+            return a + i * M;
+        }
+
+        constexpr const T* operator[](int i) const {
+            return a + i * M;
+        }
+
+        constexpr const T& operator()(size_t i, size_t j) const {
+            return a[i * M + j];
+        }
+
+        constexpr T* data() {
+            return a;
+        }
+
+        constexpr const T* data() const {
+            return a;
+        }
+
+        constexpr size_t get_stride() const {
+            return M;
+        }
+
+        constexpr void swap_rows(int i, int j) {
+            for (int k = 0; k != M; ++k) {
+                T x = a[i * M + k];
+                a[i * M + k] = a[j * M + k];
+                a[j * M + k] = x;
+            }
+        }
+
+        template <int P>
+        constexpr Matrix<T, N, P> operator*(const Matrix<T, M, P>& other) const {
+            if constexpr (N * M * P <= unroll_limit) {
+                return unrolled_product(other, make_index_sequence<N * P>());
+            } else {
+                Matrix<T, N, P> ans;
+                for (int i = 0; i != N; ++i)
+                    for (int k = 0; k != M; ++k)
+                        for (int j = 0; j != P; ++j)
+                            ans.a[i * P + j] += a[i * M + k] * other.a[k * P + j];
+                return ans;
+            }
+        }
+
+        // square and multiply
+        constexpr Matrix operator^(size_t pow) const {
+            static_assert(N == M, "linal::Matrix: power of a matrix that is not square");
+            Matrix ans = identity(), base = *this;
+            for (; pow != 0; pow >>= 1) {
+                if (pow & 1)
+                    ans = ans * base;
+                if (pow > 1)
+                    base = base * base;
+            }
+            return ans;
+        }
+
+        constexpr Matrix& operator+=(const Matrix& other) {
+            for (int k = 0; k != N * M; ++k)
+                a[k] += other.a[k];
+            return *this;
+        }
+
+        constexpr Matrix& operator-=(const Matrix& other) {
+            for (int k = 0; k != N * M; ++k)
+                a[k] -= other.a[k];
+            return *this;
+        }
+
+        constexpr Matrix& operator*=(const Matrix<T, M, M>& other) {
+            return *this = *this * other;
+        }
+
+        constexpr Matrix& operator*=(const T& x) {
+            for (int k = 0; k != N * M; ++k)
+                a[k] *= x;
+            return *this;
+        }
+
+        friend constexpr Matrix operator+(Matrix x, const Matrix& y) {
+            x += y;
+            return x;
+        }
+
+        friend constexpr Matrix operator-(Matrix x, const Matrix& y) {
+            x -= y;
+            return x;
+        }
+
+        friend constexpr Matrix operator-(Matrix x) {
+            for (int k = 0; k != N * M; ++k)
+                x.a[k] = -x.a[k];
+            return x;
+        }
+
+        friend constexpr Matrix operator*(Matrix x, const T& y) {
+            x *= y;
+            return x;
+        }
+
+        friend constexpr Matrix operator*(const T& y, Matrix x) {
+            x *= y;
+            return x;
+        }
+
+        friend constexpr bool operator==(const Matrix& x, const Matrix& y) {
+            for (int k = 0; k != N * M; ++k)
+                if (x.a[k] != y.a[k])
+                    return false;
+            return true;
+        }
+
+        friend constexpr bool operator!=(const Matrix& x, const Matrix& y) {
+            return !(x == y);
+        }
+
+        constexpr Matrix<T, M, N> transpose() const {
+            Matrix<T, M, N> ans;
+            for (int i = 0; i != N; ++i)
+                for (int j = 0; j != M; ++j)
+                    ans.a[j * N + i] = a[i * M + j];
+            return ans;
+        }
+
+        // written out without divisions up to 4 x 4 (the 4 x 4 one by the 2 x 2 minors of
+        // the upper and the lower half), larger sizes go to Matrix<T>::det()
+        constexpr T det() const {
+            static_assert(N == M, "linal::Matrix: determinant of a matrix that is not square");
+            if constexpr (N == 1) {
+                return a[0];
+            } else if constexpr (N == 2) {
+                return a[0] * a[3] - a[1] * a[2];
+            } else if constexpr (N == 3) {
+                return a[0] * (a[4] * a[8] - a[5] * a[7]) - a[1] * (a[3] * a[8] - a[5] * a[6])
+                     + a[2] * (a[3] * a[7] - a[4] * a[6]);
+            } else if constexpr (N == 4) {
+                T s[6] = {}, c[6] = {};
+                minors(s, c);
+                return s[0] * c[5] - s[1] * c[4] + s[2] * c[3] + s[3] * c[2] - s[4] * c[1] + s[5] * c[0];
+            } else {
+                return Matrix<T>(*this).det();
+            }
+        }
+
+        // adjugate over the determinant up to 4 x 4, Matrix<T>::inverse() for larger sizes.
+        // T has to be a field
+        constexpr Matrix inverse() const {
+            static_assert(N == M, "linal::Matrix: inverse of a matrix that is not square");
+            if constexpr (N > 4) {
+                return Matrix(Matrix<T>(*this).inverse());
+            } else {
+                T d = det();
+                if (d == static_cast<T>(0))
+                    throw domain_error("linal::Matrix::inverse: matrix is singular");
+                Matrix ans;
+                if constexpr (N == 1) {
+                    ans.a[0] = static_cast<T>(1);
+                } else if constexpr (N == 2) {
+                    ans.a[0] = a[3], ans.a[1] = -a[1];
+                    ans.a[2] = -a[2], ans.a[3] = a[0];
+                } else if constexpr (N == 3) {
+                    ans.a[0] = a[4] * a[8] - a[5] * a[7];
+                    ans.a[1] = a[2] * a[7] - a[1] * a[8];
+                    ans.a[2] = a[1] * a[5] - a[2] * a[4];
+                    ans.a[3] = a[5] * a[6] - a[3] * a[8];
+                    ans.a[4] = a[0] * a[8] - a[2] * a[6];
+                    ans.a[5] = a[2] * a[3] - a[0] * a[5];
+                    ans.a[6] = a[3] * a[7] - a[4] * a[6];
+                    ans.a[7] = a[1] * a[6] - a[0] * a[7];
+                    ans.a[8] = a[0] * a[4] - a[1] * a[3];
+                } else {
+                    T s[6] = {}, c[6] = {};
+                    minors(s, c);
+                    ans.a[0] = a[5] * c[5] - a[6] * c[4] + a[7] * c[3];
+                    ans.a[1] = -a[1] * c[5] + a[2] * c[4] - a[3] * c[3];
+                    ans.a[2] = a[13] * s[5] - a[14] * s[4] + a[15] * s[3];
+                    ans.a[3] = -a[9] * s[5] + a[10] * s[4] - a[11] * s[3];
+                    ans.a[4] = -a[4] * c[5] + a[6] * c[2] - a[7] * c[1];
+                    ans.a[5] = a[0] * c[5] - a[2] * c[2] + a[3] * c[1];
+                    ans.a[6] = -a[12] * s[5] + a[14] * s[2] - a[15] * s[1];
+                    ans.a[7] = a[8] * s[5] - a[10] * s[2] + a[11] * s[1];
+                    ans.a[8] = a[4] * c[4] - a[5] * c[2] + a[7] * c[0];
+                    ans.a[9] = -a[0] * c[4] + a[1] * c[2] - a[3] * c[0];
+                    ans.a[10] = a[12] * s[4] - a[13] * s[2] + a[15] * s[0];
+                    ans.a[11] = -a[8] * s[4] + a[9] * s[2] - a[11] * s[0];
+                    ans.a[12] = -a[4] * c[3] + a[5] * c[1] - a[6] * c[0];
+                    ans.a[13] = a[0] * c[3] - a[1] * c[1] + a[2] * c[0];
+                    ans.a[14] = -a[12] * s[3] + a[13] * s[1] - a[14] * s[0];
+                    ans.a[15] = a[8] * s[3] - a[9] * s[1] + a[10] * s[0];
+                }
+                ans *= static_cast<T>(1) / d;
+                return ans;
+            }
+        }
+
+        friend ostream& operator<<(ostream& out, const Matrix& x) {
+            for (int i = 0; i != N; ++i)
+                for (int j = 0; j != M; ++j)
+                    out << x.a[i * M + j] << "\t\n"[j == M - 1];
+            return out;
+        }
+    };
+}
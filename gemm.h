@@ -0,0 +1,204 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "instrumentation.h"
+
+// Cache-blocked matrix multiplication for built-in arithmetic types.
+// C += A * B, where A is n x k, B is k x m and C is n x m.
+// A and B are addressed through (row step, column step), so a transposed
+// operand costs nothing; C is row-major with line distance ldc.
+
+namespace linal {
+    // int64_t is long on LP64 targets, so long long is listed on its own
+    template <typename T>
+    struct is_gemm_scalar : std::integral_constant<bool,
+        std::is_same<T, double>::value || std::is_same<T, float>::value ||
+        std::is_same<T, int64_t>::value || std::is_same<T, long long>::value || std::is_same<T, int32_t>::value> {};
+
+    namespace gemm_detail {
+        #define LINAL_GEMM_INLINE __attribute__((always_inline)) inline
+
+        template <typename T, size_t W>
+        struct simd {
+            typedef T type __attribute__((vector_size(sizeof(T) * W)));
+        };
+
+        // register tile is MR x (NV * W), W = lanes in one vector register
+        template <typename T, size_t Bytes, size_t _MR, size_t _NV>
+        struct config {
+            static constexpr size_t W = Bytes / sizeof(T);
+            static constexpr size_t MR = _MR;
+            static constexpr size_t NV = _NV;
+            static constexpr size_t NR = _NV * W;
+            static constexpr size_t KC = 256;                    // panel of B stays in L2
+            static constexpr size_t MC = MR * (96 / MR + 1);     // panel of A stays in L2
+            static constexpr size_t NC = 4096;                   // block of B stays in L3
+        };
+
+        // copies A[0, mc) x [0, kc) into MR-line panels, p-th column of a panel is contiguous
+        template <typename T, size_t MR>
+        LINAL_GEMM_INLINE void pack_a(size_t mc, size_t kc, const T* a, ptrdiff_t rs, ptrdiff_t cs, T* out) {
+            for (size_t i = 0; i < mc; i += MR) {
+                size_t h = std::min(MR, mc - i);
+                for (size_t p = 0; p != kc; ++p) {
+                    for (size_t r = 0; r != h; ++r)
+                        out[r] = a[(i + r) * rs + p * cs];
+                    for (size_t r = h; r != MR; ++r)
+                        out[r] = T(0);
+                    out += MR;
+                }
+            }
+        }
+
+        // copies B[0, kc) x [0, nc) into NR-column panels, p-th line of a panel is contiguous
+        template <typename T, size_t NR>
+        LINAL_GEMM_INLINE void pack_b(size_t kc, size_t nc, const T* b, ptrdiff_t rs, ptrdiff_t cs, T* out) {
+            for (size_t j = 0; j < nc; j += NR) {
+                size_t w = std::min(NR, nc - j);
+                for (size_t p = 0; p != kc; ++p) {
+                    for (size_t c = 0; c != w; ++c)
+                        out[c] = b[p * rs + (j + c) * cs];
+                    for (size_t c = w; c != NR; ++c)
+                        out[c] = T(0);
+                    out += NR;
+                }
+            }
+        }
+
+        // C[0, MR) x [0, NR) += packed A panel * packed B panel
+        template <typename T, typename Cfg>
+        LINAL_GEMM_INLINE void micro_kernel(size_t kc, const T* a, const T* b, T* c, size_t ldc) {
+            typedef typename simd<T, Cfg::W>::type V;
+            V acc[Cfg::MR][Cfg::NV];
+            #pragma GCC unroll 16
+            for (size_t i = 0; i != Cfg::MR; ++i)
+                #pragma GCC unroll 4
+                for (size_t j = 0; j != Cfg::NV; ++j)
+                    acc[i][j] = V{};
+            for (size_t p = 0; p != kc; ++p, a += Cfg::MR, b += Cfg::NR) {
+                V bv[Cfg::NV];
+                #pragma GCC unroll 4
+                for (size_t j = 0; j != Cfg::NV; ++j)
+                    std::memcpy(&bv[j], b + j * Cfg::W, sizeof(V));
+                #pragma GCC unroll 16
+                for (size_t i = 0; i != Cfg::MR; ++i) {
+                    T x = a[i];
+                    #pragma GCC unroll 4
+                    for (size_t j = 0; j != Cfg::NV; ++j)
+                        acc[i][j] += x * bv[j];
+                }
+            }
+            #pragma GCC unroll 16
+            for (size_t i = 0; i != Cfg::MR; ++i) {
+                #pragma GCC unroll 4
+                for (size_t j = 0; j != Cfg::NV; ++j) {
+                    V cur;
+                    std::memcpy(&cur, c + i * ldc + j * Cfg::W, sizeof(V));
+                    cur += acc[i][j];
+                    std::memcpy(c + i * ldc + j * Cfg::W, &cur, sizeof(V));
+                }
+            }
+        }
+
+        template <typename T, typename Cfg>
+        LINAL_GEMM_INLINE void driver(size_t n, size_t m, size_t k,
+                                      const T* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+                                      const T* b, ptrdiff_t b_rs, ptrdiff_t b_cs,
+                                      T* c, size_t ldc) {
+            const size_t MR = Cfg::MR, NR = Cfg::NR;
+            std::vector<T> packed_a(Cfg::MC * Cfg::KC), packed_b(std::min(Cfg::NC, (m + NR - 1) / NR * NR) * Cfg::KC);
+            T tile[Cfg::MR * Cfg::NR];
+            for (size_t jc = 0; jc < m; jc += Cfg::NC) {
+                size_t nc = std::min(Cfg::NC, m - jc);
+                for (size_t pc = 0; pc < k; pc += Cfg::KC) {
+                    size_t kc = std::min(Cfg::KC, k - pc);
+                    pack_b<T, Cfg::NR>(kc, nc, b + pc * b_rs + jc * b_cs, b_rs, b_cs, packed_b.data());
+                    for (size_t ic = 0; ic < n; ic += Cfg::MC) {
+                        size_t mc = std::min(Cfg::MC, n - ic);
+                        pack_a<T, Cfg::MR>(mc, kc, a + ic * a_rs + pc * a_cs, a_rs, a_cs, packed_a.data());
+                        for (size_t jr = 0; jr < nc; jr += NR) {
+                            size_t w = std::min(NR, nc - jr);
+                            const T* bp = packed_b.data() + jr * kc;
+                            for (size_t ir = 0; ir < mc; ir += MR) {
+                                size_t h = std::min(MR, mc - ir);
+                                const T* ap = packed_a.data() + ir * kc;
+                                T* cp = c + (ic + ir) * ldc + jc + jr;
+                                if (h == MR && w == NR) {
+                                    micro_kernel<T, Cfg>(kc, ap, bp, cp, ldc);
+                                } else {
+                                    // edge of C: compute the full tile aside and add the valid part
+                                    std::fill(tile, tile + MR * NR, T(0));
+                                    micro_kernel<T, Cfg>(kc, ap, bp, tile, NR);
+                                    for (size_t i = 0; i != h; ++i)
+                                        for (size_t j = 0; j != w; ++j)
+                                            cp[i * ldc + j] += tile[i * NR + j];
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        template <typename T>
+        using kernel_t = void (*)(size_t, size_t, size_t, const T*, ptrdiff_t, ptrdiff_t,
+                                  const T*, ptrdiff_t, ptrdiff_t, T*, size_t);
+
+        // 16-byte vectors are available on every target gcc and clang support
+        template <typename T>
+        void gemm_generic(size_t n, size_t m, size_t k, const T* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+                          const T* b, ptrdiff_t b_rs, ptrdiff_t b_cs, T* c, size_t ldc) {
+            driver<T, config<T, 16, 4, 2>>(n, m, k, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc);
+        }
+
+#if defined(__x86_64__) || defined(__i386__)
+        template <typename T>
+        __attribute__((target("avx2,fma")))
+        void gemm_avx2(size_t n, size_t m, size_t k, const T* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+                       const T* b, ptrdiff_t b_rs, ptrdiff_t b_cs, T* c, size_t ldc) {
+            driver<T, config<T, 32, 6, 2>>(n, m, k, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc);
+        }
+
+        template <typename T>
+        __attribute__((target("avx512f,avx512dq")))
+        void gemm_avx512(size_t n, size_t m, size_t k, const T* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+                         const T* b, ptrdiff_t b_rs, ptrdiff_t b_cs, T* c, size_t ldc) {
+            driver<T, config<T, 64, 12, 2>>(n, m, k, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc);
+        }
+#endif
+
+        // picked once per type, by what the running cpu supports
+        template <typename T>
+        kernel_t<T> select_kernel() {
+#if defined(__x86_64__) || defined(__i386__)
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+                return gemm_avx512<T>;
+            if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+                return gemm_avx2<T>;
+#endif
+            return gemm_generic<T>;
+        }
+
+        #undef LINAL_GEMM_INLINE
+    }
+
+    template <typename T>
+    void gemm(size_t n, size_t m, size_t k,
+              const T* a, ptrdiff_t a_rs, ptrdiff_t a_cs,
+              const T* b, ptrdiff_t b_rs, ptrdiff_t b_cs,
+              T* c, size_t ldc) {
+        static_assert(is_gemm_scalar<T>::value, "gemm works with double, float, int64_t, long long and int32_t");
+        static const gemm_detail::kernel_t<T> kernel = gemm_detail::select_kernel<T>();
+        if (n == 0 || m == 0 || k == 0)
+            return;
+        LINAL_COUNT(multiplications, n * m * k);
+        kernel(n, m, k, a, a_rs, a_cs, b, b_rs, b_cs, c, ldc);
+    }
+}
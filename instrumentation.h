@@ -0,0 +1,159 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <map>
+#include <memory>
+#include <ostream>
+#include <string>
+
+// Opt-in counters and timers for the hot paths, enabled by defining LINAL_INSTRUMENT
+// (the CMake option of the same name). Without it LINAL_SCOPE and LINAL_COUNT expand
+// to nothing and Matrix storage uses std::allocator, so nothing is left in the code.
+//
+// LINAL_SCOPE("Matrix::gauss") at the top of a method times it and charges it with
+// everything counted until it returns, nested calls included: scalar multiplications
+// and divisions of the matrix scalar type, gcd calls of fractions, and allocations
+// and bytes of Matrix buffers. Every thread keeps its own summary, so the work of
+// pool threads in a parallel call shows up in their summaries, not in the caller's.
+
+namespace linal {
+    namespace instrument {
+        struct Counters {
+            uint64_t multiplications = 0, divisions = 0, gcd_calls = 0, allocations = 0, bytes = 0;
+
+            Counters& operator+=(const Counters& other) {
+                multiplications += other.multiplications, divisions += other.divisions;
+                gcd_calls += other.gcd_calls, allocations += other.allocations, bytes += other.bytes;
+                return *this;
+            }
+
+            Counters operator-(const Counters& other) const {
+                Counters ans = *this;
+                ans.multiplications -= other.multiplications, ans.divisions -= other.divisions;
+                ans.gcd_calls -= other.gcd_calls, ans.allocations -= other.allocations, ans.bytes -= other.bytes;
+                return ans;
+            }
+        };
+
+        // one scope name: how often it ran, for how long and what it did
+        struct Entry {
+            uint64_t calls = 0;
+            double seconds = 0;
+            Counters counters;
+        };
+
+#ifdef LINAL_INSTRUMENT
+        const bool enabled = true;
+
+        // running totals of this thread
+        inline Counters& totals() {
+            thread_local Counters counters;
+            return counters;
+        }
+
+        inline std::map<std::string, Entry>& entries() {
+            thread_local std::map<std::string, Entry> ans;
+            return ans;
+        }
+
+        class Scope {
+          private:
+            const char* name;
+            Counters start;
+            std::chrono::steady_clock::time_point started;
+
+          public:
+            explicit Scope(const char* _name) : name(_name), start(totals()), started(std::chrono::steady_clock::now()) {}
+
+            Scope(const Scope&) = delete;
+
+            ~Scope() {
+                Entry& e = entries()[name];
+                ++e.calls;
+                e.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+                e.counters += totals() - start;
+            }
+        };
+
+        // std::allocator that counts what it hands out
+        template <typename T>
+        struct counting_allocator {
+            typedef T value_type;
+
+            counting_allocator() = default;
+
+            template <typename U>
+            counting_allocator(const counting_allocator<U>&) {}
+
+            T* allocate(size_t k) {
+                ++totals().allocations;
+                totals().bytes += k * sizeof(T);
+                return std::allocator<T>().allocate(k);
+            }
+
+            void deallocate(T* p, size_t k) {
+                std::allocator<T>().deallocate(p, k);
+            }
+
+            template <typename U>
+            bool operator==(const counting_allocator<U>&) const {
+                return true;
+            }
+
+            template <typename U>
+            bool operator!=(const counting_allocator<U>&) const {
+                return false;
+            }
+        };
+
+        template <typename T>
+        using allocator = counting_allocator<T>;
+
+        #define LINAL_SCOPE(name) ::linal::instrument::Scope linal_scope(name)
+        #define LINAL_COUNT(counter, k) (::linal::instrument::totals().counter += (k))
+#else
+        const bool enabled = false;
+
+        inline std::map<std::string, Entry>& entries() {
+            static std::map<std::string, Entry> ans;
+            return ans;
+        }
+
+        template <typename T>
+        using allocator = std::allocator<T>;
+
+        #define LINAL_SCOPE(name) ((void)0)
+        #define LINAL_COUNT(counter, k) ((void)0)
+#endif
+
+        // the summary of the calling thread, by scope name
+        inline const std::map<std::string, Entry>& summary() {
+            return entries();
+        }
+
+        inline void reset() {
+            entries().clear();
+        }
+
+        // the summary of the calling thread as a table, one scope per line
+        inline void report(std::ostream& out) {
+            if (!enabled) {
+                out << "linal: instrumentation is off, build with LINAL_INSTRUMENT\n";
+                return;
+            }
+            out << std::left << std::setw(36) << "scope" << std::right << std::setw(10) << "calls"
+                << std::setw(14) << "seconds" << std::setw(16) << "mul" << std::setw(14) << "div"
+                << std::setw(14) << "gcd" << std::setw(10) << "allocs" << std::setw(14) << "bytes" << "\n";
+            for (const auto& x : entries()) {
+                const Counters& c = x.second.counters;
+                out << std::left << std::setw(36) << x.first << std::right << std::setw(10) << x.second.calls
+                    << std::setw(14) << x.second.seconds << std::setw(16) << c.multiplications
+                    << std::setw(14) << c.divisions << std::setw(14) << c.gcd_calls
+                    << std::setw(10) << c.allocations << std::setw(14) << c.bytes << "\n";
+            }
+        }
+    }
+}
@@ -2,191 +2,903 @@
 #include "polynomial.h"
 #include "rational.h"
 #include "permutation.h"
+#include "gemm.h"
+#include "strassen.h"
+#include "thread_pool.h"
+#include "instrumentation.h"
+#include "modint.h"
+#include "matrix_expr.h"
 
 using namespace std;
 
 namespace linal {
+    // scalars where a * b / b == a holds exactly, so fraction-free elimination works
     template <typename T>
-    class Matrix {
+    struct has_exact_division : integral_constant<bool, is_integral<T>::value> {};
+
+    template <typename Int, bool Lazy>
+    struct has_exact_division<BasicRational<Int, Lazy>> : true_type {};
+
+    template <>
+    struct has_exact_division<BigInt> : true_type {};
+
+    template <uint32_t P>
+    struct has_exact_division<ModInt<P>> : true_type {};
+
+    // scalars with division by every nonzero element
+    template <typename T>
+    struct is_field : integral_constant<bool, is_floating_point<T>::value> {};
+
+    template <typename Int, bool Lazy>
+    struct is_field<BasicRational<Int, Lazy>> : true_type {};
+
+    template <uint32_t P>
+    struct is_field<ModInt<P>> : true_type {};
+
+    // fields whose elements do not grow under arithmetic; exact fractions do,
+    // so they are better off with division-free methods
+    template <typename T>
+    struct is_bounded_field : integral_constant<bool, is_floating_point<T>::value> {};
+
+    template <uint32_t P>
+    struct is_bounded_field<ModInt<P>> : true_type {};
+
+    // scalars whose products cost far more than a machine operation (fractions, big integers),
+    // products of their matrices trade multiplications for additions by Strassen-Winograd
+    template <typename T>
+    struct has_expensive_product : integral_constant<bool, !is_integral<T>::value && !is_bounded_field<T>::value> {};
+
+    // whether x is a better pivot than cur: the largest for floating scalars, the first nonzero otherwise
+    template <typename T>
+    bool better_pivot(const T& x, const T& cur) {
+        if constexpr (is_floating_point<T>::value)
+            return abs(x) > abs(cur);
+        else
+            return cur == static_cast<T>(0) && x != static_cast<T>(0);
+    }
+
+    // non-owning view of a row (step = 1) or a column (step = stride)
+    template <typename T>
+    class VectorView {
+      private:
+        T* data_;
+        size_t n, step;
+
+      public:
+        VectorView(T* _data, size_t _n, size_t _step = 1) : data_(_data), n(_n), step(_step) {}
+
+        size_t size() const {
+            return n;
+        }
+
+        T& operator[](size_t i) const {
+            return data_[i * step];
+        }
+
+        T* data() const {
+            return data_;
+        }
+    };
+
+    template <typename T>
+    class PowerSequence;
+
+    template <typename T>
+    class Matrix<T, dynamic, dynamic> : public MatrixExpr<Matrix<T>> {
       private:
+        typedef vector<T, instrument::allocator<T>> Storage;
+
         int n, m;
-        vector <vector <T>> a;
+        size_t stride;      // distance between the starts of two lines, stride >= m
+        Storage a;          // row-major, element (i, j) is a[i * stride + j]
+
+        template <typename E>
+        using if_expr = typename enable_if<is_same<typename E::value_type, T>::value>::type;
+
+        void check_same_size(const pair<int, int>& other) const {
+            if (size() != other)
+                throw invalid_argument("linal::Matrix: sizes do not match");
+        }
+
+        // calls f(i, j) for every entry, by 32 x 32 tiles if the expression
+        // reads some matrix along its columns, line by line otherwise
+        template <bool tiled, typename F>
+        void for_each_entry(F f) {
+            if constexpr (tiled) {
+                const size_t tile = 32;
+                for (size_t i0 = 0; i0 < n; i0 += tile)
+                    for (size_t j0 = 0; j0 < m; j0 += tile)
+                        for (size_t i = i0; i != min<size_t>(n, i0 + tile); ++i)
+                            for (size_t j = j0; j != min<size_t>(m, j0 + tile); ++j)
+                                f(i, j);
+            } else {
+                for (size_t i = 0; i != n; ++i)
+                    for (size_t j = 0; j != m; ++j)
+                        f(i, j);
+            }
+        }
+
+        // moves the lines to a wider stride, keeps capacity for amortized append_right
+        void grow_stride(size_t new_stride) {
+            Storage b(n * new_stride);
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    b[i * new_stride + j] = std::move(a[i * stride + j]);
+            a.swap(b);
+            stride = new_stride;
+        }
+
+        // n * m machine epsilons of the largest line sum |a_i1| + ... + |a_im|: entries below it
+        // after elimination are rounding noise. max(n, m) epsilons, as for singular values,
+        // is too tight for an LU-based rank on rank-deficient products
+        T zero_tolerance() const {
+            T norm = 0;
+            for (size_t i = 0; i != n; ++i) {
+                T sum = 0;
+                for (size_t j = 0; j != m; ++j)
+                    sum += abs((*this)[i][j]);
+                norm = max(norm, sum);
+            }
+            return norm * n * m * numeric_limits<T>::epsilon();
+        }
+
+        // columns [j0, m) of lines [i0, i1) += f * the same columns of lines [k0, k0 + k);
+        // f is (i1 - i0) x k with line stride ldf, the source lines are not among the target ones
+        void add_product(size_t i0, size_t i1, size_t j0, const T* f, size_t ldf, size_t k0, size_t k,
+                         const ExecutionPolicy& policy) {
+            parallel_for(policy, i0, i1, 64, [&](size_t l, size_t r) {
+                if constexpr (is_gemm_scalar<T>::value) {
+                    gemm<T>(r - l, m - j0, k, f + (l - i0) * ldf, ldf, 1, (*this)[k0] + j0, stride, 1, (*this)[l] + j0, stride);
+                } else {
+                    for (size_t i = l; i != r; ++i)
+                        for (size_t t = 0; t != k; ++t) {
+                            const T& x = f[(i - i0) * ldf + t];
+                            if (x == static_cast<T>(0))
+                                continue;
+                            LINAL_COUNT(multiplications, m - j0);
+                            const T* line = (*this)[k0 + t];
+                            for (size_t j = j0; j != m; ++j)
+                                (*this)[i][j] += x * line[j];
+                        }
+                }
+            });
+        }
+
+        // row echelon form for floating scalars: partial pivoting, columns whose remaining
+        // entries are all below the tolerance are skipped. Blocked: a panel of columns is
+        // eliminated on its own, the rest of the matrix is updated once per panel by GEMM
+        vector<size_t> floating_echelon(const ExecutionPolicy& policy) {
+            const size_t block = 64;
+            T tol = zero_tolerance();
+            vector<size_t> pivots;
+            size_t row = 0;
+            for (size_t c0 = 0; c0 < m && row != n; c0 += block) {
+                size_t c1 = min<size_t>(m, c0 + block), r0 = row;
+                vector<T> mult((n - r0) * block);      // multiplier of line r0 + i for the t-th pivot of the panel
+                size_t k = 0;
+                for (size_t c = c0; c != c1 && row != n; ++c) {
+                    size_t p = row;
+                    for (size_t i = row + 1; i != n; ++i)
+                        if (abs((*this)[i][c]) > abs((*this)[p][c]))
+                            p = i;
+                    if (abs((*this)[p][c]) <= tol)
+                        continue;
+                    if (p != row) {
+                        swap_rows(p, row);
+                        swap_ranges(mult.begin() + (p - r0) * block, mult.begin() + (p - r0 + 1) * block,
+                                    mult.begin() + (row - r0) * block);
+                    }
+                    const T* line = (*this)[row];
+                    LINAL_COUNT(divisions, n - row - 1);
+                    for (size_t i = row + 1; i != n; ++i) {
+                        T x = (*this)[i][c] / line[c];
+                        mult[(i - r0) * block + k] = x;
+                        (*this)[i][c] = 0;
+                        if (x != 0) {
+                            LINAL_COUNT(multiplications, c1 - c - 1);
+                            for (size_t j = c + 1; j != c1; ++j)
+                                (*this)[i][j] -= x * line[j];
+                        }
+                    }
+                    pivots.push_back(c);
+                    ++row, ++k;
+                }
+                if (k == 0 || c1 == m)
+                    continue;
+                // the pivot lines get the panel's eliminations among themselves
+                for (size_t t = 1; t != k; ++t)
+                    for (size_t s = 0; s != t; ++s) {
+                        T x = mult[t * block + s];
+                        if (x != 0) {
+                            LINAL_COUNT(multiplications, m - c1);
+                            for (size_t j = c1; j != m; ++j)
+                                (*this)[r0 + t][j] -= x * (*this)[r0 + s][j];
+                        }
+                    }
+                // and the lines below them all of the panel's eliminations at once
+                vector<T> f((n - row) * k);
+                for (size_t i = row; i != n; ++i)
+                    for (size_t t = 0; t != k; ++t)
+                        f[(i - row) * k + t] = -mult[(i - r0) * block + t];
+                add_product(row, n, c1, f.data(), k, r0, k, policy);
+            }
+            for (size_t i = row; i != n; ++i)
+                fill((*this)[i], (*this)[i] + m, static_cast<T>(0));
+            return pivots;
+        }
+
+        // from row echelon form to the reduced one, blocks of pivot lines from the bottom up;
+        // the lines above a block are cleared in its pivot columns by one GEMM
+        void floating_reduce(const vector<size_t>& pivots, const ExecutionPolicy& policy) {
+            const size_t block = 64;
+            for (size_t k1 = pivots.size(); k1 != 0;) {
+                size_t k0 = k1 > block ? k1 - block : 0;
+                for (size_t t = k1; t-- != k0;) {
+                    T* line = (*this)[t];
+                    T pivot = line[pivots[t]];
+                    LINAL_COUNT(divisions, m - pivots[t]);
+                    for (size_t j = pivots[t]; j != m; ++j)
+                        line[j] /= pivot;
+                    for (size_t s = k0; s != t; ++s) {
+                        T x = (*this)[s][pivots[t]];
+                        if (x != 0) {
+                            LINAL_COUNT(multiplications, m - pivots[t]);
+                            for (size_t j = pivots[t]; j != m; ++j)
+                                (*this)[s][j] -= x * line[j];
+                        }
+                    }
+                }
+                vector<T> f(k0 * (k1 - k0));
+                for (size_t i = 0; i != k0; ++i)
+                    for (size_t t = k0; t != k1; ++t)
+                        f[i * (k1 - k0) + t - k0] = -(*this)[i][pivots[t]];
+                add_product(0, k0, pivots[k0], f.data(), k1 - k0, k0, k1 - k0, policy);
+                for (size_t i = 0; i != k0; ++i)
+                    for (size_t t = k0; t != k1; ++t)
+                        (*this)[i][pivots[t]] = 0;
+                k1 = k0;
+            }
+        }
+
+        // echelon form in place, reduced if asked; returns the pivot columns.
+        // Exact scalars pivot on the first nonzero entry, with a parallel policy
+        // the lines are eliminated in independent panels.
+        // Integers have no reduced form: they are eliminated fraction-free as in
+        // det_bareiss, every entry below a pivot line is then a minor of the input
+        vector<size_t> eliminate(const ExecutionPolicy& policy, bool reduce) {
+            if constexpr (is_floating_point<T>::value) {
+                vector<size_t> pivots = floating_echelon(policy);
+                if (reduce)
+                    floating_reduce(pivots, policy);
+                return pivots;
+            } else if constexpr (!is_field<T>::value) {
+                // gauss_in_place() does not compile for them, so reduce is false here
+                static_assert(has_exact_division<T>::value, "linal::Matrix: elimination needs exact division");
+                vector<size_t> pivots;
+                T prev = static_cast<T>(1);
+                for (size_t i = 0, main_colomn = 0; i != n && main_colomn != m; ++i, ++main_colomn) {
+                    for (size_t j = i; j != n; ++j) {
+                        if ((*this)[j][main_colomn] != static_cast<T>(0)) {
+                            swap_rows(i, j);
+                            break;
+                        }
+                    }
+                    if ((*this)[i][main_colomn] == static_cast<T>(0)) {
+                        --i;
+                        continue;
+                    }
+                    pivots.push_back(main_colomn);
+                    const T& k = (*this)[i][main_colomn];
+                    size_t grain = max<size_t>(1, 4096 / max(m, 1));
+                    parallel_for(policy, i + 1, n, grain, [&](size_t from, size_t to) {
+                        for (size_t j = from; j != to; ++j) {
+                            T f = (*this)[j][main_colomn];
+                            LINAL_COUNT(multiplications, 2 * (m - main_colomn - 1));
+                            LINAL_COUNT(divisions, m - main_colomn - 1);
+                            for (size_t l = main_colomn + 1; l != m; ++l)
+                                (*this)[j][l] = ((*this)[j][l] * k - f * (*this)[i][l]) / prev;
+                            (*this)[j][main_colomn] = static_cast<T>(0);
+                        }
+                    });
+                    prev = k;
+                }
+                return pivots;
+            } else {
+                vector<size_t> pivots;
+                for (size_t i = 0, main_colomn = 0; i != n && main_colomn != m; ++i, ++main_colomn) {
+                    for (size_t j = i; j != n; ++j) {
+                        if ((*this)[j][main_colomn] != static_cast<T>(0)) {
+                            swap_rows(i, j);
+                            break;
+                        }
+                    }
+                    if ((*this)[i][main_colomn] == static_cast<T>(0)) {
+                        --i;
+                        continue;
+                    }
+                    pivots.push_back(main_colomn);
+                    T k = (*this)[i][main_colomn];
+                    LINAL_COUNT(divisions, m - main_colomn);
+                    for (size_t j = main_colomn; j != m; ++j)
+                        (*this)[i][j] /= k;
+                    // the pivot line is zero left of main_colomn, lines with zero there stay as they are
+                    size_t grain = max<size_t>(1, 4096 / max(m, 1));
+                    parallel_for(policy, reduce ? 0 : i + 1, n, grain, [&](size_t from, size_t to) {
+                        for (size_t j = from; j != to; ++j) {
+                            if (j == i || (*this)[j][main_colomn] == static_cast<T>(0))
+                                continue;
+                            T k = (*this)[j][main_colomn];
+                            LINAL_COUNT(multiplications, m - main_colomn);
+                            for (size_t l = main_colomn; l != m; ++l)
+                                (*this)[j][l] -= (*this)[i][l] * k;
+                        }
+                    });
+                }
+                return pivots;
+            }
+        }
 
       public:
         Matrix(int _n = 0, int _m = -1) : n(_n), m(_m) {
             if (m == -1)
                 m = n;     // if n = m
-            a.resize(n, vector <T> (m));
+            stride = m;
+            a.resize(n * stride);
+        }
+
+        Matrix(const vector <vector <T>>& _a) : n(_a.size()), m(_a.empty() ? 0 : _a[0].size()) {
+            stride = m;
+            a.reserve(n * stride);
+            for (const vector <T>& line : _a)
+                a.insert(a.end(), line.begin(), line.end());
+        }
+
+        Matrix(const Matrix& other) = default;
+
+        // evaluates an expression in one pass
+        template <typename E, typename = if_expr<E>>
+        Matrix(const MatrixExpr<E>& expr) : Matrix(expr.self().size().first, expr.self().size().second) {
+            const E& e = expr.self();
+            for_each_entry<E::tiled>([&](size_t i, size_t j) { (*this)[i][j] = e(i, j); });
+        }
+
+        // the moved-from matrix is left empty
+        Matrix(Matrix&& other) noexcept : n(other.n), m(other.m), stride(other.stride), a(std::move(other.a)) {
+            other.n = other.m = 0, other.stride = 0;
+        }
+
+        Matrix& operator=(const Matrix& other) = default;
+
+        Matrix& operator=(Matrix&& other) noexcept {
+            if (this != &other) {
+                n = other.n, m = other.m, stride = other.stride;
+                a = std::move(other.a);
+                other.n = other.m = 0, other.stride = 0;
+                other.a.clear();
+            }
+            return *this;
         }
 
-        Matrix(vector <vector <T>> _a) : a(_a), n(_a.size()), m(_a[0].size()) {}
+        // in place unless the expression has to read entries of *this after they are written
+        template <typename E, typename = if_expr<E>>
+        Matrix& operator=(const MatrixExpr<E>& expr) {
+            const E& e = expr.self();
+            if (size() != e.size() || (E::tiled && e.refers_to(this)))
+                return *this = Matrix(e);
+            for_each_entry<E::tiled>([&](size_t i, size_t j) { (*this)[i][j] = e(i, j); });
+            return *this;
+        }
 
+        // room for lines x columns without reallocation in append_down and append_right
+        void reserve(size_t lines, size_t columns) {
+            if (columns > stride)
+                grow_stride(columns);
+            a.reserve(lines * stride);
+        }
 
         // {lines, columns}
         pair<int, int> size() const {
             return {n, m};
         }
 
+        // expression interface, see matrix_expr.h
+
+        typedef T value_type;
+        static const bool tiled = false;
+
+        const T& operator()(size_t i, size_t j) const {
+            return a[i * stride + j];
+        }
+
+        bool refers_to(const void* p) const {
+            return p == this;
+        }
+
         // operators
 
-        vector <T>& operator[](int i) {
-            return a[i];
+        // a[i][j] works as before, but the line is not copied
+        T* operator[](int i) {
+            return a.data() + i * stride;
         }
 
-        vector <T> operator[](int i) const {
-            return a[i];
+        const T* operator[](int i) const {
+            return a.data() + i * stride;
         }
 
-        Matrix<T> operator*(const Matrix<T>& other) const {
-            Matrix<T> ans(n, other.size().second);
-            for (size_t i = 0; i != n; ++i)
-                for (size_t j = 0; j != other.size().second; ++j)
-                    for (size_t k = 0; k != m; ++k)
-                        ans[i][j] += a[i][k] * other[k][j];
-            return ans;
+        VectorView<T> row(int i) {
+            return VectorView<T>((*this)[i], m);
         }
 
-        Matrix<T>& operator=(const Matrix& other) {
-            if (this == &other)
-                return *this;
-            n = other.n, m = other.m;
-            a = other.a;
-            return *this;
+        VectorView<const T> row(int i) const {
+            return VectorView<const T>((*this)[i], m);
         }
 
-        // works if pow >= 0
-        Matrix<T> operator^(size_t pow) const {
-            Matrix<T> ans(*this);
-            if (pow == 0) {
-                for (size_t i = 0; i != n; ++i)
-                    for (size_t j = 0; j != n; ++j)
-                        ans[i][j] = i == j ? 1 : 0;
-            } else  {
-                for (size_t i = 1; i != pow; ++i)
-                    ans = ans * (*this);
+        VectorView<T> col(int j) {
+            return VectorView<T>(a.data() + j, n, stride);
+        }
+
+        VectorView<const T> col(int j) const {
+            return VectorView<const T>(a.data() + j, n, stride);
+        }
+
+        T* data() {
+            return a.data();
+        }
+
+        const T* data() const {
+            return a.data();
+        }
+
+        size_t get_stride() const {
+            return stride;
+        }
+
+        void swap_rows(int i, int j) {
+            if (i != j)
+                swap_ranges((*this)[i], (*this)[i] + m, (*this)[j]);
+        }
+
+        // line i becomes line p[i], *this = P * *this for P = PermutationMatrix(p).
+        // Lines are swapped along the cycles of p, works in O(n * m) without a copy
+        void permute_rows(const Permutation& p) {
+            if (p.size() != n)
+                throw invalid_argument("linal::Matrix::permute_rows: sizes do not match");
+            vector<bool> seen(n);
+            for (size_t i = 0; i != n; ++i) {
+                if (seen[i])
+                    continue;
+                seen[i] = true;
+                for (size_t j = i; p[j] != int(i); j = p[j]) {
+                    seen[p[j]] = true;
+                    swap_rows(j, p[j]);
+                }
+            }
+        }
+
+        // column j becomes column p[j], *this = *this * P^T for P = PermutationMatrix(p).
+        // Every line is permuted in place along the cycles of p, works in O(n * m)
+        void permute_cols(const Permutation& p) {
+            if (p.size() != m)
+                throw invalid_argument("linal::Matrix::permute_cols: sizes do not match");
+            vector<vector<int>> cycles = p.cycles();
+            for (size_t i = 0; i != n; ++i) {
+                T* line = (*this)[i];
+                for (const vector<int>& c : cycles)
+                    for (size_t k = 0; k + 1 < c.size(); ++k)
+                        swap(line[c[k]], line[c[k + 1]]);
             }
+        }
+
+        // ans[i0, i1) x [j0, j1) = (this * other)[i0, i1) x [j0, j1)
+        // double, float and integers go to the blocked kernel from gemm.h, large panels
+        // of fractions and big integers to strassen.h, other types use i-k-j order:
+        // both ans and other are walked along their lines
+        void multiply_panel(const Matrix<T>& other, Matrix<T>& ans, size_t i0, size_t i1, size_t j0, size_t j1) const {
+            if constexpr (is_gemm_scalar<T>::value) {
+                gemm<T>(i1 - i0, j1 - j0, m, (*this)[i0], stride, 1, other.data() + j0, other.stride, 1, ans[i0] + j0, ans.stride);
+                return;
+            }
+            if constexpr (has_expensive_product<T>::value)
+                if (min({i1 - i0, j1 - j0, size_t(m)}) > strassen::cutover) {
+                    strassen::multiply(i1 - i0, j1 - j0, m, (*this)[i0], stride, other.data() + j0, other.stride,
+                                       ans[i0] + j0, ans.stride);
+                    return;
+                }
+            LINAL_COUNT(multiplications, (i1 - i0) * (j1 - j0) * m);
+            for (size_t i = i0; i != i1; ++i) {
+                T* res = ans[i];
+                for (size_t k = 0; k != m; ++k) {
+                    const T& x = (*this)[i][k];
+                    const T* line = other[k];
+                    for (size_t j = j0; j != j1; ++j)
+                        res[j] += x * line[j];
+                }
+            }
+        }
+
+        // the product is cut into panels of lines and columns, one task per panel
+        Matrix<T> mul(const Matrix<T>& other, const ExecutionPolicy& policy) const {
+            LINAL_SCOPE("Matrix::mul");
+            size_t k = other.size().second;
+            Matrix<T> ans(n, k);
+            if (n == 0 || k == 0)
+                return ans;
+            size_t rows = n, cols = k;
+            if (policy.threads > 1)
+                rows = 192, cols = 1024;
+            size_t row_panels = (n + rows - 1) / max<size_t>(rows, 1), col_panels = (k + cols - 1) / max<size_t>(cols, 1);
+            parallel_for(policy, 0, row_panels * col_panels, 1, [&](size_t l, size_t r) {
+                for (size_t t = l; t != r; ++t) {
+                    size_t i0 = t / col_panels * rows, j0 = t % col_panels * cols;
+                    multiply_panel(other, ans, i0, min<size_t>(n, i0 + rows), j0, min(k, j0 + cols));
+                }
+            });
             return ans;
         }
 
-        Matrix<T> operator-(const Matrix& other) const {
-            Matrix<T> ans(n);
+        // square and multiply, O(log pow) products
+        Matrix<T> operator^(size_t pow) const {
+            LINAL_SCOPE("Matrix::operator^");
+            Matrix<T> ans(n), base(*this);
             for (size_t i = 0; i != n; ++i)
-                for (size_t j = 0; j != n; ++j)
-                    ans[i][j] = a[i][j] - other[i][j];
+                ans[i][i] = 1;
+            bool identity = true;   // skips the product with I
+            for (; pow != 0; pow >>= 1) {
+                if (pow & 1) {
+                    ans = identity ? base : ans * base;
+                    identity = false;
+                }
+                if (pow > 1)
+                    base = base * base;
+            }
             return ans;
         }
 
-        void append_down(Matrix other) {
+        // in-place operators
+
+        template <typename E, typename = if_expr<E>>
+        Matrix<T>& operator+=(const MatrixExpr<E>& expr) {
+            const E& e = expr.self();
+            check_same_size(e.size());
+            if (E::tiled && e.refers_to(this))
+                return *this += Matrix(e);
+            for_each_entry<E::tiled>([&](size_t i, size_t j) { (*this)[i][j] += e(i, j); });
+            return *this;
+        }
+
+        template <typename E, typename = if_expr<E>>
+        Matrix<T>& operator-=(const MatrixExpr<E>& expr) {
+            const E& e = expr.self();
+            check_same_size(e.size());
+            if (E::tiled && e.refers_to(this))
+                return *this -= Matrix(e);
+            for_each_entry<E::tiled>([&](size_t i, size_t j) { (*this)[i][j] -= e(i, j); });
+            return *this;
+        }
+
+        // the product needs its own buffer, it is moved in
+        Matrix<T>& operator*=(const Matrix& other) {
+            return *this = *this * other;
+        }
+
+        Matrix<T>& operator*=(const T& x) {
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    (*this)[i][j] *= x;
+            return *this;
+        }
+
+        // the buffer grows geometrically, so appending k lines one by one costs O(k * m)
+        void append_down(const Matrix& other) {
+            if (n == 0 && m != other.size().second)
+                m = other.size().second, stride = m;
+            a.resize(n * stride);
+            for (size_t i = 0; i != other.size().first; ++i) {
+                a.insert(a.end(), other[i], other[i] + other.size().second);
+                a.resize((n + i + 1) * stride);
+            }
             n += other.size().first;
-            for (size_t i = 0; i != other.size().first; ++i)
-                a.push_back(other[i]);
         }
 
-        void append_right(Matrix other) {
-            m += other.size().second;
+        // an empty matrix takes the buffer of a temporary over
+        void append_down(Matrix&& other) {
+            if (n == 0 && a.capacity() == 0) {
+                *this = std::move(other);
+                return;
+            }
+            append_down(static_cast<const Matrix&>(other));
+        }
+
+        // the stride is doubled when the lines run out of room
+        void append_right(const Matrix& other) {
+            size_t new_m = m + other.size().second;
+            if (new_m > stride)
+                grow_stride(max(new_m, 2 * stride));
             for (size_t i = 0; i != other.size().first; ++i)
                 for (size_t j = 0; j != other.size().second; ++j)
-                    a[i].push_back(other[i][j]);
+                    (*this)[i][m + j] = other[i][j];
+            m = new_m;
         }
 
-        Matrix<T> transpose() const {
+        // lazy A^T, evaluated by tiles on assignment and read in place by products
+        using MatrixExpr<Matrix<T>>::transpose;
+
+        // goes by 32 x 32 tiles, so both matrices are read along cache lines;
+        // panels of 32 lines are independent tasks
+        Matrix<T> transpose(const ExecutionPolicy& policy) const {
+            LINAL_SCOPE("Matrix::transpose");
             Matrix<T> ans(m, n);
-            for (size_t i = 0; i != n; ++i)
-                for (size_t j = 0; j != m; ++j)
-                    ans[j][i] = (*this)[i][j];
+            const size_t tile = 32;
+            parallel_for(policy, 0, (n + tile - 1) / tile, 1, [&](size_t l, size_t r) {
+                for (size_t i0 = l * tile; i0 < min<size_t>(n, r * tile); i0 += tile)
+                    for (size_t j0 = 0; j0 < m; j0 += tile)
+                        for (size_t i = i0; i != min<size_t>(n, i0 + tile); ++i)
+                            for (size_t j = j0; j != min<size_t>(m, j0 + tile); ++j)
+                                ans[j][i] = (*this)[i][j];
+            });
             return ans;
         }
 
-        // By definition
-        // Works in O(n!)
+        // LU for bounded fields (with partial pivoting for floating ones), Bareiss elimination
+        // for other exact scalars, by definition for everything else
         T det() const {
-            T ans = 0;
-            Permutation p(n);
+            LINAL_SCOPE("Matrix::det");
+            if constexpr (is_bounded_field<T>::value)
+                return det_lu();
+            else if constexpr (has_exact_division<T>::value)
+                return det_bareiss();
+            else
+                return det_by_definition();
+        }
+
+        // fraction-free: every division is exact and intermediate values are minors of *this
+        // Works in O(n^3)
+        T det_bareiss() const {
+            Matrix<T> b = *this;
+            T prev = static_cast<T>(1);
+            bool negate = false;
+            for (size_t k = 0; k != n; ++k) {
+                if (b[k][k] == static_cast<T>(0)) {
+                    size_t i = k + 1;
+                    while (i != n && b[i][k] == static_cast<T>(0))
+                        ++i;
+                    if (i == n)
+                        return static_cast<T>(0);
+                    b.swap_rows(i, k);
+                    negate = !negate;
+                }
+                LINAL_COUNT(multiplications, 2 * (n - k - 1) * (n - k - 1));
+                LINAL_COUNT(divisions, (n - k - 1) * (n - k - 1));
+                for (size_t i = k + 1; i != n; ++i) {
+                    for (size_t j = k + 1; j != n; ++j)
+                        b[i][j] = (b[i][j] * b[k][k] - b[i][k] * b[k][j]) / prev;
+                }
+                prev = b[k][k];
+            }
+            if (n == 0)
+                return static_cast<T>(1);
+            return negate ? -b[n - 1][n - 1] : b[n - 1][n - 1];
+        }
+
+        // LU with partial pivoting, the largest remaining entry of a column is the pivot
+        // (any nonzero one for exact fields)
+        // Works in O(n^3)
+        T det_lu() const {
+            Matrix<T> b = *this;
+            T ans = static_cast<T>(1);
+            for (size_t k = 0; k != n; ++k) {
+                size_t pivot = k;
+                for (size_t i = k + 1; i != n; ++i)
+                    if (better_pivot(b[i][k], b[pivot][k]))
+                        pivot = i;
+                if (b[pivot][k] == static_cast<T>(0))
+                    return static_cast<T>(0);
+                if (pivot != k) {
+                    b.swap_rows(pivot, k);
+                    ans = -ans;
+                }
+                ans *= b[k][k];
+                LINAL_COUNT(multiplications, 1 + (n - k - 1) * (n - k - 1));
+                LINAL_COUNT(divisions, n - k - 1);
+                for (size_t i = k + 1; i != n; ++i) {
+                    T f = b[i][k] / b[k][k];
+                    for (size_t j = k + 1; j != n; ++j)
+                        b[i][j] -= f * b[k][j];
+                }
+            }
+            return ans;
+        }
+
+        // By definition, kept to check the other methods
+        // Works in O(n * n!): Heap's order keeps the sign of every permutation in O(1)
+        T det_by_definition() const {
+            T ans = static_cast<T>(0);
+            PermutationEnumerator e(n);
             do {
-                T sum = 1;
+                const Permutation& p = e.permutation();
+                T sum = static_cast<T>(1);
+                LINAL_COUNT(multiplications, n);
                 for (size_t i = 0; i != n; ++i) {
-                    sum *= a[i][p[i]];
+                    sum *= (*this)[i][p[i]];
                 }
-                ans += p.sign() * sum;
-            } while (p.next_perm());
+                if (e.sign() < 0)
+                    ans -= sum;
+                else
+                    ans += sum;
+            } while (e.next());
             return ans;
         }
 
         // ^{-1}
+        // in-place Gauss-Jordan: column k of the identity is never stored, its place holds
+        // column k of the inverse; line swaps are undone by one column permutation at the end.
+        // Works in O(n^3), T has to be a field
         Matrix<T> inverse() const {
-            T current_det = (*this).det();
-            Matrix<T> ans(n);
-            for (size_t i = 0; i != n; ++i) {
-                for (size_t j = 0; j != n; ++j) {
-                    Matrix<T> b(n - 1);
-                    for (size_t k = 0; k != i; ++k)
-                        for (size_t l = 0; l != j; ++l)
-                            b[k][l] = a[k][l];
-                    for (size_t k = 0; k != i; ++k)
-                        for (size_t l = j + 1; l != n; ++l)
-                            b[k][l - 1] = a[k][l];
-                    for (size_t k = i + 1; k != n; ++k)
-                        for (size_t l = 0; l != j; ++l)
-                            b[k - 1][l] = a[k][l];
-                    for (size_t k = i + 1; k != n; ++k)
-                        for (size_t l = j + 1; l != n; ++l)
-                            b[k - 1][l - 1] = a[k][l];
-                    ans[j][i] = b.det();
-                    if ((i + j) % 2)
-                        ans[j][i] *= -1;
-                    ans[j][i] /= current_det;
+            LINAL_SCOPE("Matrix::inverse");
+            if (n != m)
+                throw invalid_argument("linal::Matrix::inverse: matrix is not square");
+            Matrix<T> ans = *this;
+            vector<size_t> swapped(n);
+            for (size_t k = 0; k != n; ++k) {
+                size_t pivot = k;
+                for (size_t i = k + 1; i != n; ++i)
+                    if (better_pivot(ans[i][k], ans[pivot][k]))
+                        pivot = i;
+                if (ans[pivot][k] == static_cast<T>(0))
+                    throw domain_error("linal::Matrix::inverse: matrix is singular");
+                ans.swap_rows(k, pivot);
+                swapped[k] = pivot;
+                T p = ans[k][k];
+                ans[k][k] = static_cast<T>(1);
+                LINAL_COUNT(divisions, n);
+                for (size_t j = 0; j != n; ++j)
+                    ans[k][j] /= p;
+                for (size_t i = 0; i != n; ++i) {
+                    if (i == k || ans[i][k] == static_cast<T>(0))
+                        continue;
+                    T f = ans[i][k];
+                    ans[i][k] = static_cast<T>(0);
+                    LINAL_COUNT(multiplications, n);
+                    for (size_t j = 0; j != n; ++j)
+                        ans[i][j] -= f * ans[k][j];
                 }
             }
+            Permutation cols(n);
+            for (size_t k = n; k-- != 0;)
+                swap(cols[k], cols[swapped[k]]);
+            ans.permute_cols(cols);
             return ans;
         }
 
-        // by definition
-        // O(n!) - same complexity as det()
+        // det(A - xI)
+        // Hessenberg reduction for bounded fields, works in O(n^3),
+        // Berkowitz algorithm without divisions for other rings and fractions, works in O(n^4)
         Polynomial<T> characteristic_polynomial() const {
-            vector <T> temp = {0, -1};
+            LINAL_SCOPE("Matrix::characteristic_polynomial");
+            vector<T> ans = is_bounded_field<T>::value ? hessenberg_characteristic() : berkowitz_characteristic();
+            if (n % 2)
+                for (T& x : ans)
+                    x = -x;
+            return Polynomial<T>(ans);
+        }
+
+        // coefficients of det(xI - A), lowest first.
+        // A is brought to upper Hessenberg form H by similarity transforms, then
+        // p_k = (x - h_kk) p_{k - 1} - sum_{i < k} h_ik * h_{i + 1, i} * ... * h_{k, k - 1} * p_{i - 1}
+        vector<T> hessenberg_characteristic() const {
+            Matrix<T> h = *this;
+            for (size_t k = 0; k + 2 < n; ++k) {
+                size_t pivot = k + 1;
+                for (size_t i = k + 2; i != n; ++i)
+                    if (better_pivot(h[i][k], h[pivot][k]))
+                        pivot = i;
+                if (h[pivot][k] == static_cast<T>(0))
+                    continue;
+                if (pivot != k + 1) {
+                    h.swap_rows(pivot, k + 1);
+                    for (size_t i = 0; i != n; ++i)
+                        swap(h[i][pivot], h[i][k + 1]);
+                }
+                for (size_t i = k + 2; i != n; ++i) {
+                    if (h[i][k] == static_cast<T>(0))
+                        continue;
+                    T f = h[i][k] / h[k + 1][k];
+                    LINAL_COUNT(divisions, 1);
+                    LINAL_COUNT(multiplications, 2 * n - k);
+                    for (size_t j = k; j != n; ++j)
+                        h[i][j] -= f * h[k + 1][j];
+                    for (size_t j = 0; j != n; ++j)
+                        h[j][k + 1] += f * h[j][i];
+                }
+            }
+            vector<vector<T>> p(n + 1);
+            p[0] = {static_cast<T>(1)};
+            for (size_t k = 1; k <= n; ++k) {
+                p[k].assign(k + 1, static_cast<T>(0));
+                LINAL_COUNT(multiplications, k);
+                for (size_t d = 0; d != k; ++d) {
+                    p[k][d + 1] += p[k - 1][d];
+                    p[k][d] -= h[k - 1][k - 1] * p[k - 1][d];
+                }
+                T prod = static_cast<T>(1);
+                for (size_t i = k - 1; i-- != 0;) {
+                    prod *= h[i + 1][i];
+                    if (prod == static_cast<T>(0))
+                        break;
+                    T f = h[i][k - 1] * prod;
+                    LINAL_COUNT(multiplications, i + 3);
+                    for (size_t d = 0; d != i + 1; ++d)
+                        p[k][d] -= f * p[i][d];
+                }
+            }
+            return p[n];
+        }
+
+        // coefficients of det(xI - A), lowest first.
+        // Berkowitz: p_k = T_k p_{k - 1}, T_k is the Toeplitz matrix of
+        // 1, -a_kk, -R C, -R M C, -R M^2 C, ... for the leading k x k block M
+        vector<T> berkowitz_characteristic() const {
+            vector<T> p = {static_cast<T>(1)};     // highest first
+            for (size_t k = 0; k != n; ++k) {
+                vector<T> t(k + 2, static_cast<T>(0));
+                t[0] = static_cast<T>(1);
+                t[1] = -(*this)[k][k];
+                vector<T> v(k), w(k);
+                for (size_t i = 0; i != k; ++i)
+                    v[i] = (*this)[i][k];
+                LINAL_COUNT(multiplications, k * (k + k * k) + (k + 1) * (k + 4) / 2);
+                for (size_t s = 0; s != k; ++s) {
+                    T r = static_cast<T>(0);
+                    for (size_t i = 0; i != k; ++i)
+                        r += (*this)[k][i] * v[i];
+                    t[s + 2] = -r;
+                    for (size_t i = 0; i != k; ++i) {
+                        w[i] = static_cast<T>(0);
+                        for (size_t j = 0; j != k; ++j)
+                            w[i] += (*this)[i][j] * v[j];
+                    }
+                    swap(v, w);
+                }
+                vector<T> q(k + 2, static_cast<T>(0));
+                for (size_t i = 0; i != k + 2; ++i)
+                    for (size_t j = 0; j <= i && j != k + 1; ++j)
+                        q[i] += t[i - j] * p[j];
+                p.swap(q);
+            }
+            reverse(p.begin(), p.end());
+            return p;
+        }
+
+        // by definition
+        // O(n!) - same complexity as det_by_definition()
+        Polynomial<T> characteristic_polynomial_by_definition() const {
             Matrix <Polynomial <T>> b(n);
             for (size_t i = 0; i != n; ++i) {
                 for (size_t j = 0; j != n; ++j) {
                     if (i != j)
-                        b[i][j] = Polynomial<T>(a[i][j]);
+                        b[i][j] = Polynomial<T>((*this)[i][j]);
                     else
-                        b[i][j] = Polynomial<T>(vector<T>{a[i][j], -1});
+                        b[i][j] = Polynomial<T>(vector<T>{(*this)[i][j], -1});
                 }
             }
             return b.det();
         }
 
         // gaussian elimination, works in O(n^3)
-        Matrix<T> gauss() const {
-            Matrix<T> ans(size().first, size().second);
-            for (size_t i = 0; i != size().first; ++i)
-                for (size_t j = 0; j != size().second; ++j)
-                    ans[i][j] = Rational((*this)[i][j]);
-            for (size_t i = 0, main_colomn = 0; i != ans.size().first && main_colomn != ans.size().second; ++i, ++main_colomn) {
-                for (size_t j = i; j != ans.size().first; ++j) {
-                    if (ans[j][main_colomn] != static_cast<T>(0)) {
-                        swap(ans[i], ans[j]);
-                        break;
-                    }
-                }
-                if (ans[i][main_colomn] == static_cast<T>(0)) {
-                    --i;
-                    continue;
-                }
-                Rational k = ans[i][main_colomn];
-                for (size_t j = main_colomn; j != ans.size().second; ++j)
-                    ans[i][j] /= k;
-                for (size_t j = 0; j != ans.size().first; ++j) {
-                    Rational k = ans[j][main_colomn];
-                    for (size_t l = 0; l != ans.size().second; ++l) {
-                        if (j != i)
-                            ans[j][l] -= ans[i][l] * k;
-                    }
-                }
-            }
+        Matrix<T> gauss(const ExecutionPolicy& policy = execution::seq) const {
+            LINAL_SCOPE("Matrix::gauss");
+            Matrix<T> ans(*this);
+            ans.gauss_in_place(policy);
             return ans;
         }
 
+        // reduced row echelon form without a copy, returns the pivot column of every nonzero line
+        vector<size_t> gauss_in_place(const ExecutionPolicy& policy = execution::seq) {
+            static_assert(is_field<T>::value, "linal::Matrix: the reduced echelon form needs a field, use Rational entries");
+            LINAL_SCOPE("Matrix::gauss_in_place");
+            return eliminate(policy, true);
+        }
+
         // checks if A is a solution to (this * x = 0)
         bool is_solution(const Matrix& x) const {
             Matrix<T> res;
@@ -200,81 +912,70 @@ namespace linal {
 
         // fundemental system of solutions
         Matrix<T> ker() const {
-            Matrix<T> gaussed = this -> gauss();
+            LINAL_SCOPE("Matrix::ker");
+            Matrix<T> gaussed(*this);
+            vector<size_t> pivots = gaussed.gauss_in_place();
             vector <int> main(gaussed.size().second, -1);   // if the variable is main, gives its line, otherwise -1
-            for (size_t i = 0; i != gaussed.size().first; ++i) {
-                for (size_t j = 0; j != gaussed.size().second; ++j) {
-                    if (gaussed[i][j] == 1) {
-                        main[j] = i;
-                        break;
-                    }
-                }
-            }
-            Matrix<T> ans(0, gaussed.size().second);
-            for (size_t j = 0; j != gaussed.size().second; ++j) {
+            for (size_t i = 0; i != pivots.size(); ++i)
+                main[pivots[i]] = i;
+            Matrix<T> ans(m, m - pivots.size());        // one column per free variable
+            for (size_t j = 0, k = 0; j != m; ++j) {
                 if (main[j] != -1)
                     continue;
-                Matrix<T> cur(1, gaussed.size().second);
-                cur[0][j] = 1;
+                ans[j][k] = 1;
                 for (size_t i = 0; i != j; ++i)
                     if (main[i] != -1)
-                        cur[0][i] = -gaussed[main[i]][j];
-                ans.append_down(cur);
+                        ans[i][k] = -gaussed[main[i]][j];
+                ++k;
             }
-            return ans.transpose();
+            return ans;
         }
 
         // applies gaussian elimination and erases zero lines
+        // (the nonzero lines of the reduced form come first, one per pivot)
         Matrix<T> im() const {
-            Matrix<T> gaussed = (this -> transpose()).gauss();
-            Matrix<T> ans(0, gaussed.size().second);
-            for (size_t i = 0; i != gaussed.size().first; ++i) {
-                Matrix<T> cur_line(1, gaussed.size().second);
-                bool to_append = false;
-                for (size_t j = 0; j != gaussed.size().second; ++j) {
-                    cur_line[0][j] = gaussed[i][j];
-                    if (gaussed[i][j] != 0)
-                        to_append = true;
-                }
-                if (to_append)
-                    ans.append_down(cur_line);
-            }
-            return ans.transpose();
-        }
-
-        size_t rk() const {
-            Matrix<T> gaussed = this -> gauss();
-            size_t ans = 0;
-            for (size_t i = 0; i < gaussed.size().first; ++i) {
-                bool non_empty = false;
-                for (size_t j = 0; j < gaussed.size().second; ++j)
-                    if (gaussed[i][j] != static_cast<T>(0))
-                        non_empty = true;
-                ans += non_empty;
-            }
+            LINAL_SCOPE("Matrix::im");
+            Matrix<T> gaussed = transpose();
+            size_t rank = gaussed.gauss_in_place().size();
+            Matrix<T> ans(n, rank);
+            for (size_t i = 0; i != rank; ++i)
+                for (size_t j = 0; j != n; ++j)
+                    ans[j][i] = gaussed[i][j];
             return ans;
         }
 
+        // the number of pivots of the echelon form, the reduction above them is skipped;
+        // floating entries below zero_tolerance() do not count, integers are eliminated fraction-free
+        size_t rk(const ExecutionPolicy& policy = execution::seq) const {
+            LINAL_SCOPE("Matrix::rk");
+            Matrix<T> echelon(*this);
+            return echelon.eliminate(policy, false).size();
+        }
+
         // from position pos append J(x, sz)
         void append_jordan_matrix(T x, size_t sz, size_t pos) {
             for (size_t i = pos; i != pos + sz; ++i) {
-                a[i][i] = x;
+                (*this)[i][i] = x;
                 if (i != pos)
-                    a[i - 1][i] = 1; 
+                    (*this)[i - 1][i] = 1; 
             }
         }
 
         // jordan normal form
+        // The ranks of (A - xI)^i only fall until they stabilize, so the powers are
+        // taken one product at a time and stop there
         Matrix<T> jnf(vector<T> eigenvalues) const {
+            LINAL_SCOPE("Matrix::jnf");
             size_t last_free = 0;
             Matrix<T> ans(n);
             for (T& x : eigenvalues) {
                 vector<size_t> ranks(n + 2);
-                Matrix<T> cur = *this;
-                for (size_t i = 0; i != n; ++i)
-                    cur[i][i] -= x;
-                for (size_t i = 0; i != n + 2; ++i)
-                    ranks[i] = (cur ^ i).rk();
+                PowerSequence<T> powers(*this - identity(n, x));
+                ranks[0] = n;
+                for (size_t i = 1; i != n + 2; ++i) {
+                    bool stable = ranks[i - 1] == 0 || (i > 1 && ranks[i - 1] == ranks[i - 2]);
+                    ranks[i] = stable ? ranks[i - 1] : powers.next().rk();
+                }
                 for (size_t i = 1; i != n + 1; ++i) {
                     size_t sz = ranks[i - 1] - 2 * ranks[i] + ranks[i + 1];
                     for (size_t j = 0; j != sz; ++j) {
@@ -287,29 +988,352 @@ namespace linal {
         }
 
         Matrix<T> eigenvectors(vector <T> eigenvalues) const {
+            LINAL_SCOPE("Matrix::eigenvectors");
             Matrix<T> ans(n, 0);
             for (T& x : eigenvalues) {
-                Matrix<T> cur = *this;
-                for (size_t i = 0; i != n; ++i)
-                    cur[i][i] -= x;
+                Matrix<T> cur = *this - identity(n, x);
                 ans.append_right(cur.ker());
             }
             return ans;
         }
     };
 
+    // the permutation matrix of p, P[i][p[i]] = 1: line i of P * A is line p[i] of A.
+    // Only p is stored, products with a Matrix move its lines or columns in O(n * m)
+    class PermutationMatrix {
+      private:
+        Permutation p;
+
+      public:
+        explicit PermutationMatrix(const Permutation& _p) : p(_p) {}
+
+        // identity
+        explicit PermutationMatrix(size_t n) : p(n) {}
+
+        pair<int, int> size() const {
+            return {int(p.size()), int(p.size())};
+        }
+
+        const Permutation& permutation() const {
+            return p;
+        }
+
+        int det() const {
+            return p.sign();
+        }
+
+        // the inverse as well
+        PermutationMatrix transpose() const {
+            return PermutationMatrix(p ^ -1);
+        }
+
+        // P(p) * P(q) = P(q * p)
+        PermutationMatrix operator*(const PermutationMatrix& other) const {
+            return PermutationMatrix(other.p * p);
+        }
+
+        template <typename T>
+        explicit operator Matrix<T>() const {
+            Matrix<T> ans(p.size(), p.size());
+            for (size_t i = 0; i != p.size(); ++i)
+                ans[i][p[i]] = static_cast<T>(1);
+            return ans;
+        }
+    };
+
+    // P * A, line by line into a new matrix
+    template <typename T>
+    Matrix<T> operator*(const PermutationMatrix& p, const Matrix<T>& a) {
+        if (p.size().second != a.size().first)
+            throw invalid_argument("linal::Matrix: sizes do not match");
+        size_t n = a.size().first, m = a.size().second;
+        Matrix<T> ans(n, m);
+        for (size_t i = 0; i != n; ++i)
+            copy(a[p.permutation()[i]], a[p.permutation()[i]] + m, ans[i]);
+        return ans;
+    }
+
+    // P * A for a temporary A, in its place
+    template <typename T>
+    Matrix<T> operator*(const PermutationMatrix& p, Matrix<T>&& a) {
+        a.permute_rows(p.permutation());
+        return std::move(a);
+    }
+
+    // A * P: column j of A is column p[j] of the product
+    template <typename T>
+    Matrix<T> operator*(const Matrix<T>& a, const PermutationMatrix& p) {
+        if (a.size().second != p.size().first)
+            throw invalid_argument("linal::Matrix: sizes do not match");
+        size_t n = a.size().first, m = a.size().second;
+        Matrix<T> ans(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                ans[i][p.permutation()[j]] = a[i][j];
+        return ans;
+    }
+
+    // A * P for a temporary A, in its place
+    template <typename T>
+    Matrix<T> operator*(Matrix<T>&& a, const PermutationMatrix& p) {
+        a.permute_cols(p.permutation() ^ -1);
+        return std::move(a);
+    }
+
+    // A, A^2, A^3, ... each from the previous one with a single product
+    template <typename T>
+    class PowerSequence {
+      private:
+        Matrix<T> base, cur;
+        size_t pow = 0;
+
+      public:
+        // starts at A^0 = I
+        explicit PowerSequence(const Matrix<T>& _base) : base(_base), cur(Matrix<T>(_base.size().first) ^ 0) {
+            if (base.size().first != base.size().second)
+                throw invalid_argument("linal::PowerSequence: matrix is not square");
+        }
+
+        size_t exponent() const {
+            return pow;
+        }
+
+        const Matrix<T>& current() const {
+            return cur;
+        }
+
+        // moves to the next power and returns it
+        const Matrix<T>& next() {
+            cur = pow == 0 ? base : cur * base;
+            ++pow;
+            return cur;
+        }
+    };
+
+    // PA = LU, L has ones on the diagonal and both are kept in one matrix.
+    // The factorization costs O(n^3) once, every right-hand side after it costs O(n^2).
+    // T has to be a field (Rational, double, ...)
+    template <typename T>
+    class LU {
+      private:
+        size_t n;
+        Matrix<T> lu;
+        Permutation perm;       // line i of PA is line perm[i] of A
+        bool negate = false;    // parity of perm
+        bool singular = false;
+
+        void check_solvable(size_t rows) const {
+            if (singular)
+                throw domain_error("linal::LU: matrix is singular");
+            if (rows != n)
+                throw invalid_argument("linal::LU: right-hand side has wrong size");
+        }
+
+      public:
+        LU(const Matrix<T>& a) : n(a.size().first), lu(a), perm(a.size().first) {
+            LINAL_SCOPE("LU::LU");
+            if (a.size().first != a.size().second)
+                throw invalid_argument("linal::LU: matrix is not square");
+            for (size_t k = 0; k != n; ++k) {
+                size_t pivot = k;
+                for (size_t i = k + 1; i != n; ++i)
+                    if (better_pivot(lu[i][k], lu[pivot][k]))
+                        pivot = i;
+                if (lu[pivot][k] == static_cast<T>(0)) {
+                    singular = true;
+                    continue;
+                }
+                if (pivot != k) {
+                    lu.swap_rows(pivot, k);
+                    swap(perm[pivot], perm[k]);
+                    negate = !negate;
+                }
+                for (size_t i = k + 1; i != n; ++i) {
+                    if (lu[i][k] == static_cast<T>(0))
+                        continue;
+                    lu[i][k] /= lu[k][k];
+                    LINAL_COUNT(divisions, 1);
+                    LINAL_COUNT(multiplications, n - k - 1);
+                    for (size_t j = k + 1; j != n; ++j)
+                        lu[i][j] -= lu[i][k] * lu[k][j];
+                }
+            }
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+        bool is_singular() const {
+            return singular;
+        }
+
+        // L below the diagonal, U on and above it
+        const Matrix<T>& factors() const {
+            return lu;
+        }
+
+        const Permutation& permutation() const {
+            return perm;
+        }
+
+        // P of PA = LU
+        PermutationMatrix permutation_matrix() const {
+            return PermutationMatrix(perm);
+        }
+
+        T det() const {
+            if (singular)
+                return static_cast<T>(0);
+            T ans = static_cast<T>(1);
+            for (size_t i = 0; i != n; ++i)
+                ans *= lu[i][i];
+            return negate ? -ans : ans;
+        }
+
+        // A x = b
+        vector<T> solve(const vector<T>& b) const {
+            LINAL_SCOPE("LU::solve");
+            check_solvable(b.size());
+            LINAL_COUNT(multiplications, n * (n - 1));
+            LINAL_COUNT(divisions, n);
+            vector<T> x(n);
+            for (size_t i = 0; i != n; ++i) {
+                x[i] = b[perm[i]];
+                for (size_t k = 0; k != i; ++k)
+                    x[i] -= lu[i][k] * x[k];
+            }
+            for (size_t i = n; i-- != 0;) {
+                for (size_t k = i + 1; k != n; ++k)
+                    x[i] -= lu[i][k] * x[k];
+                x[i] /= lu[i][i];
+            }
+            return x;
+        }
+
+        // A X = B, the substitutions work on whole lines of B
+        Matrix<T> solve_many(const Matrix<T>& b) const {
+            LINAL_SCOPE("LU::solve_many");
+            check_solvable(b.size().first);
+            size_t m = b.size().second;
+            LINAL_COUNT(divisions, n * m);
+            Matrix<T> x = permutation_matrix() * b;
+            for (size_t i = 0; i != n; ++i) {
+                for (size_t k = 0; k != i; ++k)
+                    if (lu[i][k] != static_cast<T>(0)) {
+                        LINAL_COUNT(multiplications, m);
+                        for (size_t j = 0; j != m; ++j)
+                            x[i][j] -= lu[i][k] * x[k][j];
+                    }
+            }
+            for (size_t i = n; i-- != 0;) {
+                for (size_t k = i + 1; k != n; ++k)
+                    if (lu[i][k] != static_cast<T>(0)) {
+                        LINAL_COUNT(multiplications, m);
+                        for (size_t j = 0; j != m; ++j)
+                            x[i][j] -= lu[i][k] * x[k][j];
+                    }
+                for (size_t j = 0; j != m; ++j)
+                    x[i][j] /= lu[i][i];
+            }
+            return x;
+        }
+
+        Matrix<T> inverse() const {
+            return solve_many(Matrix<T>(n) ^ 0);
+        }
+    };
+
     template<typename T>
-    Matrix<T> sum(Matrix<T> a, Matrix<T> b) {
-        auto c = a;
-        c.append_right(b);
+    Matrix<T> sum(const Matrix<T>& a, const Matrix<T>& b) {
+        if (a.size().first != b.size().first)
+            throw invalid_argument("linal::sum: matrices have different heights");
+        Matrix<T> c(a.size().first, a.size().second + b.size().second);
+        for (size_t i = 0; i != a.size().first; ++i) {
+            copy(a[i], a[i] + a.size().second, c[i]);
+            copy(b[i], b[i] + b.size().second, c[i] + a.size().second);
+        }
         return c.im();
     }
 
+    // an operand of a product as GEMM sees it: matrices and transposed matrices
+    // are read in place through their strides, other expressions are evaluated once
+    template <typename E>
+    class GemmOperand {
+      private:
+        typedef typename E::value_type T;
+        Matrix<T> evaluated;
+
+        template <typename X>
+        struct is_transposed_matrix : false_type {};
+
+        template <typename X>
+        struct is_transposed_matrix<Transposed<Matrix<X>>> : true_type {};
+
+        void point_to(const Matrix<T>& a, bool transposed) {
+            data = a.data();
+            rs = transposed ? 1 : a.get_stride();
+            cs = transposed ? a.get_stride() : 1;
+        }
+
+      public:
+        const T* data;
+        size_t rs, cs;
+
+        explicit GemmOperand(const E& e) {
+            if constexpr (is_matrix<E>::value)
+                point_to(e, false);
+            else if constexpr (is_transposed_matrix<E>::value)
+                point_to(e.inner(), true);
+            else {
+                evaluated = e;
+                point_to(evaluated, false);
+            }
+        }
+
+        GemmOperand(const GemmOperand&) = delete;
+    };
+
+    // products are not lazy: an entry costs a whole dot product, so the result
+    // is always stored. A^T * B and A * B^T go to GEMM without a transposed copy
+    template <typename L, typename R, typename = typename enable_if<is_same<typename L::value_type, typename R::value_type>::value>::type>
+    Matrix<typename L::value_type> operator*(const MatrixExpr<L>& left, const MatrixExpr<R>& right) {
+        typedef typename L::value_type T;
+        LINAL_SCOPE("Matrix::operator*");
+        const L& l = left.self();
+        const R& r = right.self();
+        if (l.size().second != r.size().first)
+            throw invalid_argument("linal::Matrix: sizes do not match");
+        if constexpr (is_matrix<L>::value && is_matrix<R>::value) {
+            return l.mul(r, execution::seq);
+        } else if constexpr (is_gemm_scalar<T>::value) {
+            size_t n = l.size().first, k = l.size().second, m = r.size().second;
+            Matrix<T> ans(n, m);
+            if (n == 0 || m == 0 || k == 0)
+                return ans;
+            GemmOperand<L> a(l);
+            GemmOperand<R> b(r);
+            gemm<T>(n, m, k, a.data, a.rs, a.cs, b.data, b.rs, b.cs, ans.data(), ans.get_stride());
+            return ans;
+        } else {
+            return Matrix<T>(l).mul(Matrix<T>(r), execution::seq);
+        }
+    }
+
     template <typename T>
-    ostream& operator<<(ostream& out, Matrix<T> a) {
+    ostream& operator<<(ostream& out, const Matrix<T>& a) {
         for (size_t i = 0; i != a.size().first; ++i)
             for (size_t j = 0; j != a.size().second; ++j)
                 out << a[i][j] << "\t\n"[j == a.size().second - 1];
         return out;
     }
-}
\ No newline at end of file
+
+    template <typename E>
+    ostream& operator<<(ostream& out, const MatrixExpr<E>& e) {
+        return out << Matrix<typename E::value_type>(e);
+    }
+}
+
+#include "multimodular.h"
+#include "sparse.h"
+#include "fixed_matrix.h"
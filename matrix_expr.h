@@ -0,0 +1,217 @@
+#pragma once
+
+#include <cstddef>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Lazy matrix expressions: A + B, A - B, x * A, A^T and x * I are nodes that only
+// describe their entries. Assigning one to a Matrix computes every entry in a single
+// fused pass, products hand plain and transposed matrices to GEMM through strides.
+// Nodes keep references to the matrices in them, so an expression must not outlive
+// its operands (do not keep one in an auto variable past the end of the statement).
+
+namespace linal {
+    // Matrix<T> is sized at run time (linal.h), Matrix<T, N, M> at compile time (fixed_matrix.h)
+    const int dynamic = -1;
+
+    template <typename T, int N = dynamic, int M = N>
+    class Matrix;
+
+    template <typename E>
+    class Transposed;
+
+    template <typename E>
+    class Scaled;
+
+    // CRTP base: E has value_type, size() -> {lines, columns}, operator()(i, j),
+    // refers_to(p) (whether the matrix at p is a leaf of it) and a static bool tiled
+    // (whether it reads some leaf along columns, then it is evaluated by tiles)
+    template <typename E>
+    class MatrixExpr {
+      public:
+        const E& self() const {
+            return static_cast<const E&>(*this);
+        }
+
+        Transposed<E> transpose() const {
+            return Transposed<E>(self());
+        }
+    };
+
+    template <typename E>
+    struct is_matrix : std::false_type {};
+
+    template <typename T>
+    struct is_matrix<Matrix<T>> : std::true_type {};
+
+    // matrices are held by reference, nodes by value
+    template <typename E>
+    using expr_storage = typename std::conditional<is_matrix<E>::value, const E&, const E>::type;
+
+    template <typename L, typename R>
+    class Sum : public MatrixExpr<Sum<L, R>> {
+      private:
+        expr_storage<L> l;
+        expr_storage<R> r;
+
+      public:
+        typedef typename L::value_type value_type;
+        static const bool tiled = L::tiled || R::tiled;
+
+        Sum(const L& _l, const R& _r) : l(_l), r(_r) {
+            if (l.size() != r.size())
+                throw std::invalid_argument("linal::Matrix: sizes do not match");
+        }
+
+        std::pair<int, int> size() const {
+            return l.size();
+        }
+
+        value_type operator()(size_t i, size_t j) const {
+            return l(i, j) + r(i, j);
+        }
+
+        bool refers_to(const void* p) const {
+            return l.refers_to(p) || r.refers_to(p);
+        }
+    };
+
+    template <typename L, typename R>
+    class Difference : public MatrixExpr<Difference<L, R>> {
+      private:
+        expr_storage<L> l;
+        expr_storage<R> r;
+
+      public:
+        typedef typename L::value_type value_type;
+        static const bool tiled = L::tiled || R::tiled;
+
+        Difference(const L& _l, const R& _r) : l(_l), r(_r) {
+            if (l.size() != r.size())
+                throw std::invalid_argument("linal::Matrix: sizes do not match");
+        }
+
+        std::pair<int, int> size() const {
+            return l.size();
+        }
+
+        value_type operator()(size_t i, size_t j) const {
+            return l(i, j) - r(i, j);
+        }
+
+        bool refers_to(const void* p) const {
+            return l.refers_to(p) || r.refers_to(p);
+        }
+    };
+
+    template <typename E>
+    class Scaled : public MatrixExpr<Scaled<E>> {
+      private:
+        typedef typename E::value_type T;
+        expr_storage<E> e;
+        T x;
+
+      public:
+        typedef T value_type;
+        static const bool tiled = E::tiled;
+
+        Scaled(const E& _e, const T& _x) : e(_e), x(_x) {}
+
+        std::pair<int, int> size() const {
+            return e.size();
+        }
+
+        value_type operator()(size_t i, size_t j) const {
+            return x * e(i, j);
+        }
+
+        bool refers_to(const void* p) const {
+            return e.refers_to(p);
+        }
+    };
+
+    template <typename E>
+    class Transposed : public MatrixExpr<Transposed<E>> {
+      private:
+        expr_storage<E> e;
+
+      public:
+        typedef typename E::value_type value_type;
+        static const bool tiled = true;
+
+        explicit Transposed(const E& _e) : e(_e) {}
+
+        const E& inner() const {
+            return e;
+        }
+
+        std::pair<int, int> size() const {
+            return {e.size().second, e.size().first};
+        }
+
+        value_type operator()(size_t i, size_t j) const {
+            return e(j, i);
+        }
+
+        bool refers_to(const void* p) const {
+            return e.refers_to(p);
+        }
+    };
+
+    // x * I, so A - x * I is the shifted matrix without a copy of A
+    template <typename T>
+    class Identity : public MatrixExpr<Identity<T>> {
+      private:
+        int n;
+        T x;
+
+      public:
+        typedef T value_type;
+        static const bool tiled = false;
+
+        explicit Identity(int _n, const T& _x = static_cast<T>(1)) : n(_n), x(_x) {}
+
+        std::pair<int, int> size() const {
+            return {n, n};
+        }
+
+        value_type operator()(size_t i, size_t j) const {
+            return i == j ? x : static_cast<T>(0);
+        }
+
+        bool refers_to(const void*) const {
+            return false;
+        }
+    };
+
+    template <typename T>
+    Identity<T> identity(int n, const T& x = static_cast<T>(1)) {
+        return Identity<T>(n, x);
+    }
+
+    template <typename L, typename R>
+    Sum<L, R> operator+(const MatrixExpr<L>& l, const MatrixExpr<R>& r) {
+        return Sum<L, R>(l.self(), r.self());
+    }
+
+    template <typename L, typename R>
+    Difference<L, R> operator-(const MatrixExpr<L>& l, const MatrixExpr<R>& r) {
+        return Difference<L, R>(l.self(), r.self());
+    }
+
+    template <typename E>
+    Scaled<E> operator*(const MatrixExpr<E>& e, const typename E::value_type& x) {
+        return Scaled<E>(e.self(), x);
+    }
+
+    template <typename E>
+    Scaled<E> operator*(const typename E::value_type& x, const MatrixExpr<E>& e) {
+        return Scaled<E>(e.self(), x);
+    }
+
+    template <typename E>
+    Scaled<E> operator-(const MatrixExpr<E>& e) {
+        return Scaled<E>(e.self(), static_cast<typename E::value_type>(-1));
+    }
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+
+// Montgomery arithmetic modulo an odd mod < 2^31.
+// A residue x is kept as x * 2^32 mod mod, so a product needs one
+// multiplication, one multiply-add and a shift instead of a division.
+struct Montgomery {
+    uint32_t mod;
+    uint32_t neg_inv;   // -mod^{-1} mod 2^32
+    uint32_t r2;        // 2^64 mod mod
+
+    constexpr explicit Montgomery(uint32_t _mod) : mod(_mod), neg_inv(0), r2(0) {
+        uint32_t inv = mod;             // Newton: each step doubles the correct low bits
+        for (int i = 0; i != 4; ++i)
+            inv *= 2 - mod * inv;
+        neg_inv = 0 - inv;
+        r2 = uint32_t((0 - uint64_t(mod)) % mod);
+    }
+
+    // x * 2^{-32} mod mod for x < mod * 2^32
+    constexpr uint32_t reduce(uint64_t x) const {
+        uint32_t q = uint32_t(x) * neg_inv;
+        uint32_t t = uint32_t((x + uint64_t(q) * mod) >> 32);
+        return t >= mod ? t - mod : t;
+    }
+
+    constexpr uint32_t to(uint32_t x) const {
+        return reduce(uint64_t(x) * r2);
+    }
+
+    constexpr uint32_t from(uint32_t x) const {
+        return reduce(x);
+    }
+
+    constexpr uint32_t one() const {
+        return to(1);
+    }
+
+    constexpr uint32_t add(uint32_t a, uint32_t b) const {
+        uint32_t s = a + b;
+        return s >= mod ? s - mod : s;
+    }
+
+    constexpr uint32_t sub(uint32_t a, uint32_t b) const {
+        return a >= b ? a - b : a + mod - b;
+    }
+
+    constexpr uint32_t mul(uint32_t a, uint32_t b) const {
+        return reduce(uint64_t(a) * b);
+    }
+
+    constexpr uint32_t pow(uint32_t a, uint64_t k) const {
+        uint32_t ans = one();
+        for (; k != 0; k >>= 1, a = mul(a, a))
+            if (k & 1)
+                ans = mul(ans, a);
+        return ans;
+    }
+
+    // Fermat, mod has to be prime
+    constexpr uint32_t inverse(uint32_t a) const {
+        return pow(a, mod - 2);
+    }
+};
+
+// deterministic Miller-Rabin for 32-bit numbers, bases 2, 7 and 61
+inline bool is_prime(uint32_t n) {
+    if (n < 2)
+        return false;
+    for (uint32_t p : {2u, 3u, 5u, 7u, 61u})
+        if (n % p == 0)
+            return n == p;
+    uint32_t d = n - 1;
+    int s = 0;
+    for (; d % 2 == 0; d /= 2)
+        ++s;
+    for (uint64_t a : {2u, 7u, 61u}) {
+        uint64_t x = 1, b = a;
+        for (uint32_t k = d; k != 0; k >>= 1, b = b * b % n)
+            if (k & 1)
+                x = x * b % n;
+        if (x == 1 || x == n - 1)
+            continue;
+        bool composite = true;
+        for (int i = 1; i != s && composite; ++i) {
+            x = x * x % n;
+            composite = x != n - 1;
+        }
+        if (composite)
+            return false;
+    }
+    return true;
+}
+
+// Residues modulo a prime P < 2^31, usable as T in linal::Matrix<T>
+template<uint32_t P>
+class ModInt {
+    static_assert(P % 2 == 1 && P < (1u << 31), "ModInt needs an odd modulus below 2^31");
+
+  private:
+    static constexpr Montgomery mont = Montgomery(P);
+    uint32_t v;     // Montgomery form
+
+    struct raw_tag {};
+
+    constexpr ModInt(uint32_t _v, raw_tag) : v(_v) {}
+
+    static constexpr uint32_t residue(long long x) {
+        long long r = x % static_cast<long long>(P);
+        return uint32_t(r < 0 ? r + P : r);
+    }
+
+  public:
+    // constructors
+
+    constexpr ModInt(long long x = 0) : v(mont.to(residue(x))) {}
+
+    static constexpr uint32_t modulus() {
+        return P;
+    }
+
+    // the residue in [0, P)
+    constexpr uint32_t value() const {
+        return mont.from(v);
+    }
+
+    constexpr ModInt pow(uint64_t k) const {
+        return ModInt(mont.pow(v, k), raw_tag());
+    }
+
+    ModInt inverse() const {
+        if (v == 0)
+            throw std::domain_error("ModInt: division by zero");
+        return ModInt(mont.inverse(v), raw_tag());
+    }
+
+    // operators
+
+    constexpr ModInt operator-() const {
+        return ModInt(mont.sub(0, v), raw_tag());
+    }
+
+    constexpr ModInt operator+() const {
+        return *this;
+    }
+
+    friend constexpr ModInt operator+(const ModInt& a, const ModInt& b) {
+        return ModInt(mont.add(a.v, b.v), raw_tag());
+    }
+
+    friend constexpr ModInt operator-(const ModInt& a, const ModInt& b) {
+        return ModInt(mont.sub(a.v, b.v), raw_tag());
+    }
+
+    friend constexpr ModInt operator*(const ModInt& a, const ModInt& b) {
+        return ModInt(mont.mul(a.v, b.v), raw_tag());
+    }
+
+    friend ModInt operator/(const ModInt& a, const ModInt& b) {
+        return a * b.inverse();
+    }
+
+    friend constexpr ModInt& operator+=(ModInt& a, const ModInt& b) {
+        return a = a + b;
+    }
+
+    friend constexpr ModInt& operator-=(ModInt& a, const ModInt& b) {
+        return a = a - b;
+    }
+
+    friend constexpr ModInt& operator*=(ModInt& a, const ModInt& b) {
+        return a = a * b;
+    }
+
+    friend ModInt& operator/=(ModInt& a, const ModInt& b) {
+        return a = a / b;
+    }
+
+    // Montgomery form is a bijection, so it can be compared directly
+    friend constexpr bool operator==(const ModInt& a, const ModInt& b) {
+        return a.v == b.v;
+    }
+
+    friend constexpr bool operator!=(const ModInt& a, const ModInt& b) {
+        return a.v != b.v;
+    }
+
+    friend std::ostream& operator<<(std::ostream& out, const ModInt& a) {
+        return out << a.value();
+    }
+};
@@ -0,0 +1,313 @@
+#pragma once
+
+// Exact rank, determinant, reduced echelon form and kernel of integer matrices.
+// The work is done modulo many word-sized primes, independently and in parallel,
+// and the answer is put back together by the Chinese remainder theorem
+// (and rational reconstruction for fractions), so nothing ever grows past 32 bits
+// until the final combination.
+
+namespace linal {
+    namespace multimodular_detail {
+        // the count largest primes below 2^31, largest first. The shared list grows on
+        // demand, so callers get a copy taken under the lock rather than a reference
+        // that another thread's growth could invalidate
+        inline vector<uint32_t> primes(size_t count) {
+            static mutex lock;
+            static vector<uint32_t> list;
+            lock_guard<mutex> guard(lock);
+            uint32_t p = list.empty() ? (1u << 31) - 1 : list.back() - 2;
+            for (; list.size() < count; p -= 2)
+                if (is_prime(p))
+                    list.push_back(p);
+            return vector<uint32_t>(list.begin(), list.begin() + count);
+        }
+
+        template <typename T>
+        uint32_t residue(const T& x, uint32_t p) {
+            if constexpr (is_same<T, BigInt>::value) {
+                long long r = static_cast<long long>(x % BigInt(p));
+                return uint32_t(r < 0 ? r + p : r);
+            } else {
+                static_assert(is_builtin_integer<T>::value, "multimodular methods take integer matrices");
+                __int128 r = static_cast<__int128>(x) % p;
+                return uint32_t(r < 0 ? r + p : r);
+            }
+        }
+
+        // the matrix modulo p in Montgomery form, line after line
+        template <typename T>
+        vector<uint32_t> reduce(const Matrix<T>& a, const Montgomery& mg) {
+            size_t n = a.size().first, m = a.size().second;
+            vector<uint32_t> ans(n * m);
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    ans[i * m + j] = mg.to(residue(a[i][j], mg.mod));
+            return ans;
+        }
+
+        // Gauss-Jordan modulo p, returns the pivot columns; full = false stops at
+        // echelon form, which is enough for rank and determinant
+        inline vector<size_t> eliminate(const Montgomery& mg, vector<uint32_t>& a, size_t n, size_t m,
+                                        bool full, uint32_t* det = nullptr) {
+            vector<size_t> pivots;
+            uint32_t d = mg.one();
+            for (size_t col = 0, row = 0; col != m && row != n; ++col) {
+                size_t r = row;
+                while (r != n && a[r * m + col] == 0)
+                    ++r;
+                if (r == n) {
+                    d = 0;
+                    continue;
+                }
+                if (r != row) {
+                    swap_ranges(a.begin() + r * m, a.begin() + (r + 1) * m, a.begin() + row * m);
+                    d = mg.sub(0, d);
+                }
+                uint32_t* line = a.data() + row * m;
+                d = mg.mul(d, line[col]);
+                uint32_t inv = mg.inverse(line[col]);
+                for (size_t j = col; j != m; ++j)
+                    line[j] = mg.mul(line[j], inv);
+                for (size_t i = full ? 0 : row + 1; i != n; ++i) {
+                    uint32_t* cur = a.data() + i * m;
+                    if (i == row || cur[col] == 0)
+                        continue;
+                    uint32_t f = cur[col];
+                    for (size_t j = col; j != m; ++j)
+                        cur[j] = mg.sub(cur[j], mg.mul(f, line[j]));
+                }
+                pivots.push_back(col);
+                ++row;
+            }
+            if (det)
+                *det = pivots.size() == n ? mg.from(d) : 0;
+            return pivots;
+        }
+
+        // Garner: x = v_0 + v_1 p_0 + v_2 p_0 p_1 + ..., every digit is found in word arithmetic
+        class Crt {
+          private:
+            vector<uint32_t> p;
+            vector<vector<uint32_t>> inv;   // inv[i][j] = p_j^{-1} mod p_i, j < i
+            BigInt product;
+
+          public:
+            Crt(const vector<uint32_t>& _p) : p(_p), inv(_p.size()), product(1) {
+                for (size_t i = 0; i != p.size(); ++i) {
+                    for (size_t j = 0; j != i; ++j) {
+                        uint64_t x = 1, b = p[j] % p[i];
+                        for (uint32_t k = p[i] - 2; k != 0; k >>= 1, b = b * b % p[i])
+                            if (k & 1)
+                                x = x * b % p[i];
+                        inv[i].push_back(uint32_t(x));
+                    }
+                    product *= BigInt(p[i]);
+                }
+            }
+
+            const BigInt& modulus() const {
+                return product;
+            }
+
+            // the value in [0, p_0 p_1 ...) with the given residues
+            BigInt operator()(const vector<uint32_t>& r) const {
+                vector<uint32_t> v(p.size());
+                for (size_t i = 0; i != p.size(); ++i) {
+                    uint64_t t = r[i];
+                    for (size_t j = 0; j != i; ++j)
+                        t = (t + p[i] - v[j] % p[i]) % p[i] * inv[i][j] % p[i];
+                    v[i] = uint32_t(t);
+                }
+                BigInt x = 0;
+                for (size_t i = p.size(); i-- != 0;)
+                    x = x * BigInt(p[i]) + BigInt(v[i]);
+                return x;
+            }
+
+            // the value in (-M/2, M/2]
+            BigInt symmetric(const vector<uint32_t>& r) const {
+                BigInt x = (*this)(r);
+                if (x * 2 > product)
+                    x -= product;
+                return x;
+            }
+        };
+
+        // a / b = x mod m with |a|, |b| <= sqrt(m / 2), false if there is none
+        inline bool rational_reconstruction(const BigInt& x, const BigInt& m, BigRational& ans) {
+            BigInt r0 = m, r1 = x, t0 = 0, t1 = 1;
+            while (r1 * r1 * 2 > m) {
+                BigInt q = r0 / r1;
+                BigInt r2 = r0 - q * r1, t2 = t0 - q * t1;
+                r0 = r1, r1 = r2, t0 = t1, t1 = t2;
+            }
+            if (t1 * t1 * 2 > m || gcd_kernel(r1, t1) != 1)
+                return false;
+            ans = BigRational(r1, t1);
+            return true;
+        }
+
+        // for every prime, the echelon or reduced form modulo it, computed in parallel
+        template <typename T>
+        void for_primes(const Matrix<T>& a, size_t from, size_t to, const ExecutionPolicy& policy, bool full,
+                        vector<vector<uint32_t>>& forms, vector<vector<size_t>>& pivots, vector<uint32_t>* dets = nullptr) {
+            vector<uint32_t> p = primes(to);
+            forms.resize(to), pivots.resize(to);
+            if (dets)
+                dets -> resize(to);
+            size_t n = a.size().first, m = a.size().second;
+            parallel_for(policy, from, to, 1, [&](size_t l, size_t r) {
+                for (size_t k = l; k != r; ++k) {
+                    Montgomery mg(p[k]);
+                    forms[k] = reduce(a, mg);
+                    pivots[k] = eliminate(mg, forms[k], n, m, full, dets ? &(*dets)[k] : nullptr);
+                    for (uint32_t& x : forms[k])
+                        x = mg.from(x);
+                }
+            });
+        }
+
+        // log2 of Hadamard's bound on the minors of a, plus one: every minor is at most
+        // the product of the Euclidean norms of the nonzero lines it crosses
+        template <typename T>
+        double hadamard_bits(const Matrix<T>& a) {
+            double bits = 1;
+            for (size_t i = 0; i != a.size().first; ++i) {
+                double norm = 0;
+                for (size_t j = 0; j != a.size().second; ++j)
+                    norm += pow(static_cast<double>(a[i][j]), 2);
+                bits += norm > 0 ? log2(norm) / 2 : 0;
+            }
+            return bits;
+        }
+
+        // the kernel basis as columns, read off a reduced echelon form
+        template <typename R>
+        Matrix<R> kernel_of_rref(const Matrix<R>& rref, const vector<size_t>& pivots) {
+            size_t m = rref.size().second;
+            vector<int> main(m, -1);
+            for (size_t i = 0; i != pivots.size(); ++i)
+                main[pivots[i]] = i;
+            Matrix<R> ans(m, m - pivots.size());
+            for (size_t j = 0, k = 0; j != m; ++j) {
+                if (main[j] != -1)
+                    continue;
+                ans[j][k] = 1;
+                for (size_t i = 0; i != j; ++i)
+                    if (main[i] != -1)
+                        ans[i][k] = -rref[main[i]][j];
+                ++k;
+            }
+            return ans;
+        }
+    }
+
+    // rank over Q. The rank modulo p never exceeds it, and is smaller only if p divides
+    // every nonzero maximal minor. Such a minor is below Hadamard's bound, so once the
+    // product of the primes passes the bound one of them keeps the full rank: the
+    // answer is exact, not probable. Primes go in batches, and full rank stops early
+    template <typename T>
+    size_t multimodular_rk(const Matrix<T>& a, const ExecutionPolicy& policy = execution::seq) {
+        size_t count = static_cast<size_t>(multimodular_detail::hadamard_bits(a) / 30) + 1;
+        size_t full = min(a.size().first, a.size().second), batch = max<size_t>(policy.threads, 2);
+        vector<vector<uint32_t>> forms;
+        vector<vector<size_t>> pivots;
+        size_t ans = 0;
+        for (size_t done = 0; done < count && ans != full; done += batch) {
+            size_t to = min(count, done + batch);
+            multimodular_detail::for_primes(a, done, to, policy, false, forms, pivots);
+            for (size_t k = done; k != to; ++k) {
+                ans = max(ans, pivots[k].size());
+                vector<uint32_t>().swap(forms[k]);      // only the ranks are kept
+            }
+        }
+        return ans;
+    }
+
+    // exact determinant: enough primes for twice the Hadamard bound, then CRT
+    template <typename T>
+    BigInt multimodular_det(const Matrix<T>& a, const ExecutionPolicy& policy = execution::seq) {
+        if (a.size().first != a.size().second)
+            throw invalid_argument("linal::multimodular_det: matrix is not square");
+        size_t count = static_cast<size_t>(multimodular_detail::hadamard_bits(a) / 30) + 2;
+        vector<vector<uint32_t>> forms;
+        vector<vector<size_t>> pivots;
+        vector<uint32_t> dets;
+        multimodular_detail::for_primes(a, 0, count, policy, false, forms, pivots, &dets);
+        vector<uint32_t> p = multimodular_detail::primes(count);
+        return multimodular_detail::Crt(p).symmetric(dets);
+    }
+
+    // reduced row echelon form over Q. Primes whose pivots differ from the best ones
+    // (largest rank, then earliest columns) are dropped, the rest are combined until
+    // rational reconstruction gives the same answer twice; the answer is then checked
+    // exactly: its kernel has to be annihilated by the matrix
+    template <typename T>
+    Matrix<BigRational> multimodular_gauss(const Matrix<T>& a, const ExecutionPolicy& policy = execution::seq) {
+        size_t n = a.size().first, m = a.size().second;
+        vector<vector<uint32_t>> forms;
+        vector<vector<size_t>> pivots;
+        Matrix<BigRational> exact(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                exact[i][j] = BigRational(BigInt(a[i][j]));
+        size_t batch = max<size_t>(policy.threads, 2), done = 0;
+        Matrix<BigRational> last;
+        while (true) {
+            multimodular_detail::for_primes(a, done, done + batch, policy, true, forms, pivots);
+            done += batch;
+            batch = done;       // the number of primes doubles every round
+            vector<uint32_t> all = multimodular_detail::primes(done);
+            vector<size_t> best = pivots[0];
+            for (const vector<size_t>& p : pivots)
+                if (p.size() > best.size() || (p.size() == best.size() && p < best))
+                    best = p;
+            vector<size_t> good;
+            vector<uint32_t> p;
+            for (size_t k = 0; k != done; ++k)
+                if (pivots[k] == best)
+                    good.push_back(k), p.push_back(all[k]);
+            multimodular_detail::Crt crt(p);
+            Matrix<BigRational> ans(n, m);
+            bool reconstructed = true;
+            vector<uint32_t> r(good.size());
+            for (size_t i = 0; i != best.size() && reconstructed; ++i) {
+                for (size_t j = best[i]; j != m && reconstructed; ++j) {
+                    for (size_t k = 0; k != good.size(); ++k)
+                        r[k] = forms[good[k]][i * m + j];
+                    reconstructed = multimodular_detail::rational_reconstruction(crt(r), crt.modulus(), ans[i][j]);
+                }
+            }
+            if (!reconstructed)
+                continue;
+            bool stable = last.size() == ans.size();
+            for (size_t i = 0; i != n && stable; ++i)
+                for (size_t j = 0; j != m && stable; ++j)
+                    stable = last[i][j] == ans[i][j];
+            if (stable) {
+                Matrix<BigRational> check = exact * multimodular_detail::kernel_of_rref(ans, best);
+                bool zero = true;
+                for (size_t i = 0; i != check.size().first && zero; ++i)
+                    for (size_t j = 0; j != check.size().second && zero; ++j)
+                        zero = check[i][j] == 0;
+                if (zero)
+                    return ans;
+            }
+            last = ans;
+        }
+    }
+
+    // fundamental system of solutions over Q, as columns like Matrix::ker()
+    template <typename T>
+    Matrix<BigRational> multimodular_ker(const Matrix<T>& a, const ExecutionPolicy& policy = execution::seq) {
+        Matrix<BigRational> rref = multimodular_gauss(a, policy);
+        vector<size_t> pivots;
+        for (size_t i = 0; i != rref.size().first; ++i)
+            for (size_t j = 0; j != rref.size().second; ++j)
+                if (rref[i][j] != 0) {
+                    pivots.push_back(j);
+                    break;
+                }
+        return multimodular_detail::kernel_of_rref(rref, pivots);
+    }
+}
@@ -7,6 +7,16 @@ class Permutation {
     std::vector <int> p;
     size_t n;
 
+    // power_into() squares permutations longer than this for powers below squaring_power
+    static const size_t squaring_size = 1 << 18;
+    static const long long squaring_power = 32;
+
+    // keeps the capacity, the entries are to be overwritten
+    void assign_size(size_t _n) {
+        p.resize(_n);
+        n = _n;
+    }
+
   public:
 
     // constructors
@@ -41,26 +51,130 @@ class Permutation {
 
     // assuming a * b is a(b)
     Permutation operator*(const Permutation& other) const {
-        Permutation ans(n);
-        for (size_t i = 0; i != n; ++i)
-            ans[i] = p[other[i]];
+        Permutation ans(0);
+        compose_into(other, ans);
         return ans;
     }
 
-    Permutation operator^(int pow) const {
+    // *this = *this * other without a second buffer: the entries are moved along the
+    // cycles of other, moved ones are marked by storing them complemented. Works in O(n).
+    // p *= p reads the marks back through other, so squaring goes through a copy
+    Permutation& operator*=(const Permutation& other) {
+        if (&other == this) {
+            Permutation ans(0);
+            compose_into(other, ans);
+            p.swap(ans.p);
+            return *this;
+        }
+        for (size_t i = 0; i != n; ++i) {
+            if (p[i] < 0)
+                continue;
+            int first = p[i];
+            size_t j = i;
+            for (; other[j] != int(i); j = other[j])
+                p[j] = ~p[other[j]];
+            p[j] = ~first;
+        }
+        for (int& x : p)
+            x = ~x;
+        return *this;
+    }
+
+    // any power, negative ones included: every cycle is rotated by pow modulo its length.
+    // Works in O(n) whatever pow is
+    Permutation operator^(long long pow) const {
+        Permutation ans(0);
+        power_into(pow, ans);
+        return ans;
+    }
+
+    // the *_into methods write into a caller's permutation and reuse its memory,
+    // ans must not be *this or other
+
+    // ans = *this * other
+    void compose_into(const Permutation& other, Permutation& ans) const {
+        ans.assign_size(n);
+        for (size_t i = 0; i != n; ++i)
+            ans.p[i] = p[other.p[i]];
+    }
+
+    // ans = *this ^ -1
+    void inverse_into(Permutation& ans) const {
+        ans.assign_size(n);
+        for (size_t i = 0; i != n; ++i)
+            ans.p[p[i]] = i;
+    }
+
+    // ans = *this ^ pow
+    // Following the cycles is one dependent load per element, which is slow once the
+    // permutation leaves the cache, so large ones with small powers are squared and
+    // multiplied instead: a few passes over memory that the prefetcher keeps up with
+    void power_into(long long pow, Permutation& ans) const {
         if (pow == -1) {
-            // inverse
-            Permutation ans(n);
+            inverse_into(ans);
+            return;
+        }
+        if (n > squaring_size && pow < 0 && pow > -squaring_power) {
+            Permutation inv(0);
+            inverse_into(inv);
+            inv.power_into(-pow, ans);
+            return;
+        }
+        if (n > squaring_size && pow >= 0 && pow < squaring_power) {
+            Permutation base = *this, tmp(0);
+            ans.assign_size(n);
             for (size_t i = 0; i != n; ++i)
-                ans[p[i]] = i;
-            return ans;
+                ans.p[i] = i;
+            for (; pow != 0; pow >>= 1) {
+                if (pow & 1) {
+                    ans.compose_into(base, tmp);
+                    ans.p.swap(tmp.p);
+                }
+                if (pow > 1) {
+                    base.compose_into(base, tmp);
+                    base.p.swap(tmp.p);
+                }
+            }
+            return;
+        }
+        ans.assign_size(n);
+        std::vector <bool> seen(n);
+        std::vector <int> cycle;
+        for (size_t i = 0; i != n; ++i) {
+            if (seen[i])
+                continue;
+            cycle.clear();
+            for (int j = i; !seen[j]; j = p[j]) {
+                seen[j] = true;
+                cycle.push_back(j);
+            }
+            long long len = cycle.size();
+            size_t shift = (pow % len + len) % len;
+            for (size_t k = 0, t = shift; k != cycle.size(); ++k, ++t) {
+                if (t == cycle.size())
+                    t = 0;
+                ans.p[cycle[k]] = cycle[t];
+            }
         }
-        if (pow == 0)
-            return Permutation(n);
-        if (pow % 2)
-            return (*this ^ (pow - 1)) * (*this);
-        else
-            return (*this ^ (pow / 2)) * (*this ^ (pow / 2));
+    }
+
+    // *this = *this ^ -1 with no scratch at all: every cycle is reversed in place,
+    // visited entries are marked by storing them complemented. Works in O(n)
+    void invert() {
+        for (size_t i = 0; i != n; ++i) {
+            if (p[i] < 0)
+                continue;
+            int prev = i, cur = p[i];
+            while (cur != int(i)) {
+                int next = p[cur];
+                p[cur] = ~prev;
+                prev = cur;
+                cur = next;
+            }
+            p[i] = ~prev;
+        }
+        for (int& x : p)
+            x = ~x;
     }
 
     bool operator==(const Permutation& other) const {
@@ -86,15 +200,74 @@ class Permutation {
         return false;
     }
 
-    // calculates by parity of inverses in O(n^2)
-    // TODO: change to O(n) by finding out cycles
+    // every cycle starts at its smallest element, cycles go by their first elements,
+    // fixed points are cycles of length 1
+    // Works in O(n)
+    std::vector <std::vector <int>> cycles() const {
+        std::vector <std::vector <int>> ans;
+        std::vector <bool> seen(n);
+        for (size_t i = 0; i != n; ++i) {
+            if (seen[i])
+                continue;
+            ans.emplace_back();
+            for (int j = i; !seen[j]; j = p[j]) {
+                seen[j] = true;
+                ans.back().push_back(j);
+            }
+        }
+        return ans;
+    }
+
+    // a cycle of length k is k - 1 transpositions, so the sign is (-1)^(n - cycles)
+    // Works in O(n)
     int sign() const {
-        int sign = 1;
-        for (size_t i = 0; i != n; ++i)
-            for (size_t j = i + 1; j != n; ++j)
-                if (p[i] > p[j])
-                    sign *= -1;
-        return sign;
+        std::vector <bool> seen(n);
+        size_t parity = n;
+        for (size_t i = 0; i != n; ++i) {
+            if (seen[i])
+                continue;
+            --parity;
+            for (int j = i; !seen[j]; j = p[j])
+                seen[j] = true;
+        }
+        return parity % 2 ? -1 : 1;
+    }
+};
+
+// all n! permutations by Heap's algorithm, starting from id: every step is one
+// transposition, so the sign flips each time and costs nothing to keep.
+// The order is not lexicographic, use Permutation::next_perm() for that
+class PermutationEnumerator {
+  private:
+    Permutation p;
+    std::vector <size_t> c;     // the loop counters of the recursive form
+    size_t i = 1;
+    int s = 1;
+
+  public:
+    PermutationEnumerator(size_t n) : p(n), c(n) {}
+
+    const Permutation& permutation() const {
+        return p;
+    }
+
+    int sign() const {
+        return s;
+    }
+
+    // moves to the next permutation, false after the last one. O(1) amortized
+    bool next() {
+        while (i < p.size()) {
+            if (c[i] < i) {
+                std::swap(p[i % 2 ? c[i] : 0], p[i]);
+                ++c[i];
+                i = 1;
+                s = -s;
+                return true;
+            }
+            c[i++] = 0;
+        }
+        return false;
     }
 };
 
@@ -1,5 +1,8 @@
 // Class for polynomials for characteristic polynomial
 
+#include "bigint.h"
+#include "convolution.h"
+
 template<typename T>
 class Polynomial {
   private:
@@ -12,10 +15,16 @@ class Polynomial {
         ReDegree();
     }
 
-    Polynomial(const T& _a = T()) : a({_a}) {
+    Polynomial(std::vector<T>&& _a) : a(std::move(_a)) {
         ReDegree();
     }
 
+    // the zero polynomial does not allocate
+    Polynomial(const T& _a = T()) {
+        if (_a != static_cast<T>(0))
+            a.push_back(_a);
+    }
+
     template<typename It>
     Polynomial(const It& l, const It& r) {
         for (It i = l; i != r; ++i)
@@ -23,7 +32,8 @@ class Polynomial {
         ReDegree();
     }
 
-    std::vector<T> get() const {
+    // the coefficients, lowest first, without leading zeroes
+    const std::vector<T>& get() const {
         return a;
     }
 
@@ -33,24 +43,34 @@ class Polynomial {
 
     // operators
 
+    // changes existing coefficients only, so the degree stays put; set() grows
     T& operator[](size_t i) {
         if (i >= a.size())
-            a.resize(i + 1);
+            throw std::out_of_range("Polynomial: coefficient above the degree, use set()");
         return a[i];
     }
 
-    const T operator[](size_t i) const {
-        if (i >= a.size())
-            return static_cast<T>(0);
-        return a[i];
+    const T& operator[](size_t i) const {
+        static const T zero = static_cast<T>(0);
+        return i < a.size() ? a[i] : zero;
     }
 
-    T operator()(const T& x) const {
-        T ans = static_cast<T>(0), pow = static_cast<T>(1);
-        for (size_t i = 0; i != a.size(); ++i) {
-            ans += (*this)[i] * pow;
-            pow *= x;
+    // the coefficient of x^i, growing the polynomial if needed; leading zeroes are removed
+    void set(size_t i, const T& x) {
+        if (i >= a.size()) {
+            if (x == static_cast<T>(0))
+                return;
+            a.resize(i + 1, static_cast<T>(0));
         }
+        a[i] = x;
+        ReDegree();
+    }
+
+    // Horner's rule, one multiplication per coefficient
+    T operator()(const T& x) const {
+        T ans = static_cast<T>(0);
+        for (size_t i = a.size(); i-- != 0;)
+            ans = ans * x + a[i];
         return ans;
     }
 
@@ -76,6 +96,73 @@ class Polynomial {
             a.pop_back();
     }
 
+    // in-place operators, the storage of *this is reused
+
+    Polynomial& operator+=(const Polynomial& b) {
+        if (a.size() < b.a.size())
+            a.resize(b.a.size(), static_cast<T>(0));
+        for (size_t i = 0; i != b.a.size(); ++i)
+            a[i] += b.a[i];
+        ReDegree();
+        return *this;
+    }
+
+    Polynomial& operator+=(const T& b) {
+        set(0, a.empty() ? b : a[0] + b);
+        return *this;
+    }
+
+    Polynomial& operator-=(const Polynomial& b) {
+        if (a.size() < b.a.size())
+            a.resize(b.a.size(), static_cast<T>(0));
+        for (size_t i = 0; i != b.a.size(); ++i)
+            a[i] -= b.a[i];
+        ReDegree();
+        return *this;
+    }
+
+    Polynomial& operator-=(const T& b) {
+        set(0, a.empty() ? -b : a[0] - b);
+        return *this;
+    }
+
+    // short factors are multiplied in place from the top coefficient down,
+    // long ones through convolution::multiply
+    Polynomial& operator*=(const Polynomial& b) {
+        if (a.empty() || b.a.empty()) {
+            a.clear();
+            return *this;
+        }
+        if (std::min(a.size(), b.a.size()) >= convolution::schoolbook_limit || this == &b) {
+            a = convolution::multiply(a, b.a);
+        } else {
+            size_t n = a.size();
+            a.resize(n + b.a.size() - 1, static_cast<T>(0));
+            for (size_t i = n; i-- != 0;) {
+                T x = a[i];
+                a[i] = x * b.a[0];
+                for (size_t j = 1; j != b.a.size(); ++j)
+                    a[i + j] += x * b.a[j];
+            }
+        }
+        ReDegree();
+        return *this;
+    }
+
+    Polynomial& operator*=(const T& b) {
+        for (T& x : a)
+            x *= b;
+        ReDegree();
+        return *this;
+    }
+
+    Polynomial Derivative() const {
+        std::vector<T> ans(a.size() > 1 ? a.size() - 1 : 0);
+        for (size_t i = 1; i < a.size(); ++i)
+            ans[i - 1] = a[i] * static_cast<T>(i);
+        return Polynomial(ans);
+    }
+
     // makes leading coefficient 1.
     void Normalize() {
         if (Degree() >= 0 && (*this)[Degree()] != static_cast<T> (0)) {
@@ -88,148 +175,384 @@ class Polynomial {
 
 // operators
 
+// equal up to zeroes a write through the mutable operator[] may have left on top
 template<typename T>
 bool operator==(const Polynomial<T>& a, const Polynomial<T>& b) {
-    return a.get() == b.get();
+    const std::vector<T>& x = a.get();
+    const std::vector<T>& y = b.get();
+    size_t common = std::min(x.size(), y.size());
+    if (!std::equal(x.begin(), x.begin() + common, y.begin()))
+        return false;
+    const std::vector<T>& longer = x.size() > y.size() ? x : y;
+    for (size_t i = common; i != longer.size(); ++i)
+        if (longer[i] != static_cast<T>(0))
+            return false;
+    return true;
 }
 
 template<typename T>
 bool operator==(const Polynomial<T>& a, const T& b) {
-    return a == Polynomial<T>(b);
+    for (size_t i = 1; i < a.size(); ++i)
+        if (a.get()[i] != static_cast<T>(0))
+            return false;
+    return a[0] == b;
 }
 
 template<typename T>
 bool operator==(const T& a, const Polynomial<T>& b) {
-    return Polynomial<T>(a) == b;
+    return b == a;
 }
 
 template<typename T>
 bool operator!=(const Polynomial<T>& a, const Polynomial<T>& b) {
-    return a.get() != b.get();
+    return !(a == b);
 }
 
 template<typename T>
 bool operator!=(const Polynomial<T>& a, const T& b) {
-    return a != Polynomial<T>(b);
+    return !(a == b);
 }
 
 template<typename T>
 bool operator!=(const T& a, const Polynomial<T>& b) {
-    return Polynomial<T>(a) != b;
+    return !(b == a);
 }
 
+// the left operand is taken by value, so a temporary on the left is reused
+
 template<typename T>
-Polynomial<T> operator+(const Polynomial<T>& a, const Polynomial<T>& b) {
-    std::vector<T> ans(std::max(a.Degree(), b.Degree()) + 1);
-    for (size_t i = 0; i != ans.size(); ++i) {
-        if (a.size() <= i)
-            ans[i] = b[i];
-        else if (b.size() <= i)
-            ans[i] = a[i];
-        else
-            ans[i] = a[i] + b[i];
-    }
-    Polynomial<T> res(ans);
-    res.ReDegree();
-    return res;
+Polynomial<T> operator-(Polynomial<T> a) {
+    a *= static_cast<T>(-1);
+    return a;
 }
 
 template<typename T>
-Polynomial<T> operator+(const Polynomial<T>& a, const T& b) {
-    return a + Polynomial<T>(b);
+Polynomial<T> operator+(Polynomial<T> a, const Polynomial<T>& b) {
+    a += b;
+    return a;
 }
 
 template<typename T>
-Polynomial<T> operator+(const T& a, const Polynomial<T>& b) {
-    return Polynomial<T>(a) + b;
+Polynomial<T> operator+(Polynomial<T> a, const T& b) {
+    a += b;
+    return a;
 }
 
 template<typename T>
-Polynomial<T>& operator+=(Polynomial<T>& a, const Polynomial<T>& b) {
-    a = a + b;
-    return a;
+Polynomial<T> operator+(const T& a, Polynomial<T> b) {
+    b += a;
+    return b;
 }
 
 template<typename T>
-Polynomial<T>& operator+=(Polynomial<T>& a, const T& b) {
-    a = a + b;
+Polynomial<T> operator-(Polynomial<T> a, const Polynomial<T>& b) {
+    a -= b;
     return a;
 }
 
 template<typename T>
-Polynomial<T> operator-(const Polynomial<T>& a, const Polynomial<T>& b) {
-    std::vector<T> ans(std::max(a.Degree(), b.Degree()) + 1);
-    for (size_t i = 0; i != ans.size(); ++i) {
-        if (a.size() <= i)
-            ans[i] = -b[i];
-        else if (b.size() <= i)
-            ans[i] = a[i];
-        else
-            ans[i] = a[i] - b[i];
-    }
-    Polynomial<T> res(ans);
-    res.ReDegree();
-    return res;
+Polynomial<T> operator-(Polynomial<T> a, const T& b) {
+    a -= b;
+    return a;
 }
 
-
 template<typename T>
-Polynomial<T> operator-(const Polynomial<T>& a, const T& b) {
-    return a - Polynomial<T>(b);
+Polynomial<T> operator-(const T& a, Polynomial<T> b) {
+    b *= static_cast<T>(-1);
+    b += a;
+    return b;
 }
 
 template<typename T>
-Polynomial<T> operator-(const T& a, const Polynomial<T>& b) {
-    return Polynomial<T>(a) - b;
+Polynomial<T> operator*(Polynomial<T> a, const Polynomial<T>& b) {
+    a *= b;
+    return a;
 }
 
 template<typename T>
-Polynomial<T>& operator-=(Polynomial<T>& a, const Polynomial<T>& b) {
-    a = a - b;
+Polynomial<T> operator*(Polynomial<T> a, const T& b) {
+    a *= b;
     return a;
 }
 
 template<typename T>
-Polynomial<T>& operator-=(Polynomial<T>& a, const T& b) {
-    a = a - b;
-    return a;
+Polynomial<T> operator*(const T& a, Polynomial<T> b) {
+    b *= a;
+    return b;
 }
 
+// division
+
+namespace polynomial_detail {
+    // below these sizes schoolbook division and Horner's rule are faster
+    const int newton_limit = 64;
+    const size_t tree_leaf = 32;
+
+    // g with f g = 1 mod x^n, f[0] has to be invertible.
+    // Newton: g <- g (2 - f g) doubles the number of correct terms
+    template<typename T>
+    std::vector<T> inverse_series(const std::vector<T>& f, size_t n) {
+        std::vector<T> g = {static_cast<T>(1) / f[0]};
+        for (size_t k = 1; k < n;) {
+            k = std::min(2 * k, n);
+            std::vector<T> h(f.begin(), f.begin() + std::min(f.size(), k));
+            h = convolution::multiply(h, g);
+            h.resize(k, static_cast<T>(0));
+            for (T& x : h)
+                x = -x;
+            h[0] += static_cast<T>(2);
+            g = convolution::multiply(g, h);
+            g.resize(k, static_cast<T>(0));
+        }
+        g.resize(n, static_cast<T>(0));
+        return g;
+    }
+
+    // lc(b)^(deg a - deg b + 1) a mod b, stays in the ring of T
+    template<typename T>
+    Polynomial<T> pseudo_remainder(const Polynomial<T>& a, const Polynomial<T>& b) {
+        int db = b.Degree();
+        std::vector<T> r = a.get(), d = b.get();
+        for (int i = a.Degree(); i >= db; --i) {
+            T c = r[i];
+            for (int j = 0; j != i; ++j)
+                r[j] *= d[db];
+            r[i] = static_cast<T>(0);
+            for (int j = 0; j != db; ++j)
+                r[i - db + j] -= c * d[j];
+        }
+        return Polynomial<T>(r);
+    }
+
+    template<typename T>
+    T scalar_gcd(T a, T b) {
+        using std::abs;
+        while (b != static_cast<T>(0)) {
+            a %= b;
+            std::swap(a, b);
+        }
+        return abs(a);
+    }
+
+    template<typename T>
+    T content(const Polynomial<T>& a) {
+        T ans = static_cast<T>(0);
+        for (const T& x : a)
+            ans = scalar_gcd(ans, x);
+        return ans;
+    }
+
+    template<typename T>
+    Polynomial<T> divide_coefficients(const Polynomial<T>& a, const T& d) {
+        std::vector<T> ans = a.get();
+        for (T& x : ans)
+            x /= d;
+        return Polynomial<T>(ans);
+    }
+
+    // subresultant remainder sequence: every division is exact and the coefficients
+    // stay of the size of subresultants instead of growing exponentially
+    template<typename T>
+    Polynomial<T> subresultant_gcd(Polynomial<T> a, Polynomial<T> b) {
+        if (a.Degree() < b.Degree())
+            std::swap(a, b);
+        if (b.Degree() == -1)
+            return a.Degree() != -1 && a[a.Degree()] < static_cast<T>(0) ? a * static_cast<T>(-1) : a;
+        T c = scalar_gcd(content(a), content(b));
+        a = divide_coefficients(a, content(a));
+        b = divide_coefficients(b, content(b));
+        T g = static_cast<T>(1), h = static_cast<T>(1);
+        while (true) {
+            int delta = a.Degree() - b.Degree();
+            Polynomial<T> r = pseudo_remainder(a, b);
+            if (r.Degree() <= 0) {
+                if (r.Degree() == 0)
+                    b = Polynomial<T>(static_cast<T>(1));
+                break;
+            }
+            T divisor = g;
+            for (int i = 0; i != delta; ++i)
+                divisor *= h;
+            a = b;
+            b = divide_coefficients(r, divisor);
+            g = a[a.Degree()];
+            if (delta != 0) {       // h = g^delta / h^(delta - 1)
+                T num = g, den = static_cast<T>(1);
+                for (int i = 1; i != delta; ++i)
+                    num *= g, den *= h;
+                h = num / den;
+            }
+        }
+        T cont = content(b);
+        return divide_coefficients(b, b[b.Degree()] < static_cast<T>(0) ? -cont : cont) * c;
+    }
+}
+
+// quotient and remainder with deg r < deg b; T has to be a field, or b monic.
+// Long quotients come from the Newton inverse of the reversed divisor in O(M(d))
 template<typename T>
-Polynomial<T> operator*(const Polynomial<T>& a, const Polynomial<T>& b) {
-    std::vector<T> ans(a.Degree() + b.Degree() + 1, static_cast<T> (0));
-    for (size_t i = 0; i != a.size(); ++i)
-        for (size_t j = 0; j != b.size(); ++j)
-            ans[i + j] += a[i] * b[j];
-    Polynomial<T> res(ans);
-    res.ReDegree();
-    return res;
+std::pair<Polynomial<T>, Polynomial<T>> divmod(const Polynomial<T>& a, const Polynomial<T>& b) {
+    int da = a.Degree(), db = b.Degree();
+    if (db == -1)
+        throw std::domain_error("Polynomial: division by zero");
+    if (da < db)
+        return {Polynomial<T>(), a};
+    size_t k = da - db + 1;
+    if (db < polynomial_detail::newton_limit || static_cast<int>(k) < polynomial_detail::newton_limit) {
+        std::vector<T> r = a.get(), d = b.get(), q(k);
+        for (size_t i = k; i-- != 0;) {
+            q[i] = r[i + db] / d[db];
+            for (int j = 0; j <= db; ++j)
+                r[i + j] -= q[i] * d[j];
+        }
+        r.resize(db);
+        return {Polynomial<T>(q), Polynomial<T>(r)};
+    }
+    std::vector<T> ra(a.begin(), a.end()), rb(b.begin(), b.end());
+    std::reverse(ra.begin(), ra.end());
+    std::reverse(rb.begin(), rb.end());
+    ra.resize(k), rb.resize(std::min(rb.size(), k));
+    std::vector<T> q = convolution::multiply(ra, polynomial_detail::inverse_series(rb, k));
+    q.resize(k);
+    std::reverse(q.begin(), q.end());
+    Polynomial<T> quotient(q);
+    return {quotient, a - b * quotient};
 }
 
 template<typename T>
-Polynomial<T> operator*(const Polynomial<T>& a, const T& b) {
-    return a * Polynomial<T>(b);
+Polynomial<T> operator/(const Polynomial<T>& a, const Polynomial<T>& b) {
+    return divmod(a, b).first;
 }
 
 template<typename T>
-Polynomial<T> operator*(const T& a, const Polynomial<T>& b) {
-    return Polynomial<T>(a) * b;
+Polynomial<T> operator%(const Polynomial<T>& a, const Polynomial<T>& b) {
+    return divmod(a, b).second;
 }
 
+// greatest common divisor: monic over fields (Euclid), primitive with the gcd of the
+// contents over the integers (subresultants)
 template<typename T>
-Polynomial<T>& operator*=(Polynomial<T>& a, const Polynomial<T>& b) {
-    a = a * b;
-    return a;
+Polynomial<T> gcd(Polynomial<T> a, Polynomial<T> b) {
+    if constexpr (std::is_integral<T>::value || std::is_same<T, BigInt>::value) {
+        return polynomial_detail::subresultant_gcd(a, b);
+    } else {
+        while (b.Degree() != -1) {
+            a = divmod(a, b).second;
+            std::swap(a, b);
+        }
+        a.Normalize();
+        return a;
+    }
 }
 
+// products of (x - x_i) over a binary tree of point ranges, the root is the product of all.
+// Evaluation reduces a polynomial down the tree, interpolation combines values up it;
+// both are O(M(d) log d). T has to be a field
 template<typename T>
-Polynomial<T>& operator*=(Polynomial<T>& a, const T& b) {
-    a = a * b;
-    return a;
+class SubproductTree {
+  private:
+    std::vector<T> points;
+    std::vector<Polynomial<T>> tree;      // node v has children 2v + 1 and 2v + 2
+
+    void build(size_t v, size_t l, size_t r) {
+        if (tree.size() <= v)
+            tree.resize(2 * v + 1);
+        if (r - l <= polynomial_detail::tree_leaf) {
+            Polynomial<T> ans(static_cast<T>(1));
+            for (size_t i = l; i != r; ++i)
+                ans *= Polynomial<T>(std::vector<T>{-points[i], static_cast<T>(1)});
+            tree[v] = ans;
+            return;
+        }
+        size_t mid = (l + r) / 2;
+        build(2 * v + 1, l, mid);
+        build(2 * v + 2, mid, r);
+        tree[v] = tree[2 * v + 1] * tree[2 * v + 2];
+    }
+
+    void evaluate(const Polynomial<T>& p, size_t v, size_t l, size_t r, std::vector<T>& ans) const {
+        Polynomial<T> rem = p.Degree() < tree[v].Degree() ? p : p % tree[v];
+        if (r - l <= polynomial_detail::tree_leaf) {
+            for (size_t i = l; i != r; ++i)
+                ans[i] = rem(points[i]);
+            return;
+        }
+        size_t mid = (l + r) / 2;
+        evaluate(rem, 2 * v + 1, l, mid, ans);
+        evaluate(rem, 2 * v + 2, mid, r, ans);
+    }
+
+    // sum of w_i * prod_{j != i} (x - x_j) over the range of v
+    Polynomial<T> combine(const std::vector<T>& w, size_t v, size_t l, size_t r) const {
+        if (r - l <= polynomial_detail::tree_leaf) {
+            Polynomial<T> ans;
+            for (size_t i = l; i != r; ++i)
+                ans += divmod(tree[v], Polynomial<T>(std::vector<T>{-points[i], static_cast<T>(1)})).first * w[i];
+            return ans;
+        }
+        size_t mid = (l + r) / 2;
+        return combine(w, 2 * v + 1, l, mid) * tree[2 * v + 2] + combine(w, 2 * v + 2, mid, r) * tree[2 * v + 1];
+    }
+
+  public:
+    explicit SubproductTree(const std::vector<T>& _points) : points(_points) {
+        if (!points.empty())
+            build(0, 0, points.size());
+    }
+
+    // prod (x - x_i)
+    Polynomial<T> product() const {
+        return points.empty() ? Polynomial<T>(static_cast<T>(1)) : tree[0];
+    }
+
+    std::vector<T> evaluate(const Polynomial<T>& p) const {
+        std::vector<T> ans(points.size());
+        if (!points.empty())
+            evaluate(p, 0, 0, points.size(), ans);
+        return ans;
+    }
+
+    // the polynomial of degree < number of points with p(x_i) = values[i], points have to be distinct
+    Polynomial<T> interpolate(const std::vector<T>& values) const {
+        if (values.size() != points.size())
+            throw std::invalid_argument("SubproductTree::interpolate: wrong number of values");
+        if (points.empty())
+            return Polynomial<T>();
+        std::vector<T> w = evaluate(tree[0].Derivative());
+        for (size_t i = 0; i != w.size(); ++i)
+            w[i] = values[i] / w[i];
+        return combine(w, 0, 0, points.size());
+    }
+};
+
+// p at every point; few points are done one by one with Horner's rule
+template<typename T>
+std::vector<T> evaluate(const Polynomial<T>& p, const std::vector<T>& points) {
+    if (points.size() <= polynomial_detail::tree_leaf || p.Degree() < polynomial_detail::newton_limit) {
+        std::vector<T> ans(points.size());
+        for (size_t i = 0; i != points.size(); ++i)
+            ans[i] = p(points[i]);
+        return ans;
+    }
+    std::vector<T> ans;
+    ans.reserve(points.size());
+    // trees over blocks of deg p + 1 points keep the remainders short
+    size_t block = p.size();
+    for (size_t l = 0; l < points.size(); l += block) {
+        std::vector<T> part(points.begin() + l, points.begin() + std::min(points.size(), l + block));
+        std::vector<T> values = SubproductTree<T>(part).evaluate(p);
+        ans.insert(ans.end(), values.begin(), values.end());
+    }
+    return ans;
+}
+
+template<typename T>
+Polynomial<T> interpolate(const std::vector<T>& points, const std::vector<T>& values) {
+    return SubproductTree<T>(points).interpolate(values);
 }
 
 template<typename T>
-std::ostream& operator<<(std::ostream& out, Polynomial<T>& a) {
+std::ostream& operator<<(std::ostream& out, const Polynomial<T>& a) {
     if (a.Degree() == -1) {
         out << "0";
     } else if (a.Degree() == 0) {
@@ -1,162 +1,516 @@
 #include <numeric>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "bigint.h"
+#include "instrumentation.h"
+
+// built-in integers, including __int128 which is_integral only knows about in gnu mode
+template<typename Int>
+struct is_builtin_integer : std::integral_constant<bool, std::is_integral<Int>::value ||
+                                                         std::is_same<Int, __int128>::value> {};
+
+template<typename Int>
+struct unsigned_integer : std::make_unsigned<Int> {};
+
+template<>
+struct unsigned_integer<__int128> {
+    typedef unsigned __int128 type;
+};
+
+template<typename U>
+int count_trailing_zeros(U x) {
+    if constexpr (sizeof(U) <= sizeof(unsigned))
+        return __builtin_ctz(x);
+    else if constexpr (sizeof(U) <= sizeof(unsigned long long))
+        return __builtin_ctzll(x);
+    else
+        return uint64_t(x) ? __builtin_ctzll(uint64_t(x)) : 64 + __builtin_ctzll(uint64_t(x >> 64));
+}
+
+// Euclid, the result is not negative
+template<typename Int>
+Int gcd_euclid(Int a, Int b) {
+    if (a < 0)
+        a = -a;
+    if (b < 0)
+        b = -b;
+    while (b != 0) {
+        Int r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+// binary (Stein) gcd for 64- and 128-bit integers: shifts and subtractions instead of
+// divisions, which are slow at that width (bench/rational_gauss.cpp). 32-bit division is
+// cheap enough that Euclid wins there, BigInt goes through Euclid as well.
+// The result is not negative
+template<typename Int>
+Int gcd_kernel(Int a, Int b) {
+    LINAL_COUNT(gcd_calls, 1);
+    if constexpr (is_builtin_integer<Int>::value && sizeof(Int) >= 8) {
+        typedef typename unsigned_integer<Int>::type U;
+        U u = a < 0 ? U(0) - U(a) : U(a), v = b < 0 ? U(0) - U(b) : U(b);
+        if (u == 0)
+            return Int(v);
+        if (v == 0)
+            return Int(u);
+        // the shift of the next step is taken from v - u, which has the same trailing
+        // zeros as |v - u|, so it does not wait for the subtraction below
+        int uz = count_trailing_zeros(u), vz = count_trailing_zeros(v);
+        int shift = std::min(uz, vz);
+        v >>= vz;
+        while (true) {
+            u >>= uz;
+            U diff = v - u;
+            if (diff == 0)      // u == v is the odd part of the gcd, ctz(0) is undefined
+                break;
+            uz = count_trailing_zeros(diff);
+            U low = std::min(u, v);
+            u = u > v ? u - v : v - u;
+            v = low;
+        }
+        return Int(v << shift);
+    } else {
+        return gcd_euclid(a, b);
+    }
+}
 
 int gcd(int a, int b) {
-    if (!a)
-        return b;
-    return gcd(b % a, a);
+    return gcd_kernel(a, b);
+}
+
+// + - * that throw std::overflow_error instead of wrapping around;
+// BigInt never overflows, so it goes through the plain operators
+namespace checked {
+    template<typename Int>
+    Int add(const Int& a, const Int& b) {
+        if constexpr (is_builtin_integer<Int>::value) {
+            Int r;
+            if (__builtin_add_overflow(a, b, &r))
+                throw std::overflow_error("Rational: integer overflow");
+            return r;
+        } else {
+            return a + b;
+        }
+    }
+
+    template<typename Int>
+    Int sub(const Int& a, const Int& b) {
+        if constexpr (is_builtin_integer<Int>::value) {
+            Int r;
+            if (__builtin_sub_overflow(a, b, &r))
+                throw std::overflow_error("Rational: integer overflow");
+            return r;
+        } else {
+            return a - b;
+        }
+    }
+
+    template<typename Int>
+    Int mul(const Int& a, const Int& b) {
+        if constexpr (is_builtin_integer<Int>::value) {
+            Int r;
+            if (__builtin_mul_overflow(a, b, &r))
+                throw std::overflow_error("Rational: integer overflow");
+            return r;
+        } else {
+            return a * b;
+        }
+    }
+
+    // whether x keeps its value as an Int, e.g. 1LL << 40 does not in an int
+    template<typename Int, typename U>
+    bool fits(const U& x) {
+        if constexpr (is_builtin_integer<Int>::value && is_builtin_integer<U>::value) {
+            Int r;
+            return !__builtin_add_overflow(x, U(0), &r);
+        } else {
+            return true;
+        }
+    }
+
+    template<typename Int, typename U>
+    Int convert(const U& x) {
+        if (!fits<Int>(x))
+            throw std::overflow_error("Rational: integer overflow");
+        return Int(x);
+    }
 }
 
-// Class that implemets fractions for gaussian elimination
-class Rational {
+// Class that implemets fractions for gaussian elimination.
+// Int is the integer backend: int (the default Rational), int64_t, __int128 or BigInt.
+// Eager values (Lazy = false) are always irreducible, so the operators below reduce
+// crosswise before multiplying and intermediate values stay as small as the result allows.
+// Lazy values skip the gcd: they are reduced only for comparisons, output and when the
+// next operation would overflow. Their numerator() and denominator() may have a common factor.
+template<typename Int, bool Lazy = false>
+class BasicRational {
   private:
-    int a, b;
+    Int a, b;
+
+    struct raw_tag {};
+
+    // b > 0, a / b is irreducible unless Lazy
+    BasicRational(const Int& _a, const Int& _b, raw_tag) : a(_a), b(_b) {}
 
   public:
-    int numerator() const {
+    typedef Int integer_type;
+
+    const Int& numerator() const {
         return a;
     }
 
-    int denominator() const {
+    const Int& denominator() const {
         return b;
     }
 
     // makes a fraction irreducible.
     void normalize() {
-        int g = gcd(a, b);
-        a /= g, b /= g;
+        if (b == 0)
+            throw std::domain_error("Rational: zero denominator");
+        Int g = gcd_kernel(a, b);
+        if (g != 1)
+            a /= g, b /= g;
         if (b < 0) {
-            a *= -1;
-            b *= -1;
+            a = -a;
+            b = -b;
         }
     }
 
+    BasicRational reduced() const {
+        BasicRational ans = *this;
+        if (Lazy)
+            ans.normalize();
+        return ans;
+    }
+
     // constructors
 
-    Rational(int _a = 0, int _b = 1) : a(_a), b(_b) {
+    BasicRational(Int _a = 0, Int _b = 1) : a(_a), b(_b) {
         normalize();
     }
 
-    Rational(const Rational& other) : a(other.numerator()),
-                                      b(other.denominator()) {}
+    // lets BigRational be built from int and friends in one conversion;
+    // a value wider than Int throws overflow_error instead of being cut
+    template<typename I, typename = typename std::enable_if<is_builtin_integer<I>::value &&
+                                                            !std::is_same<I, Int>::value>::type>
+    BasicRational(I x) : a(checked::convert<Int>(x)), b(1) {}
+
+    template<typename I, typename J, typename = typename std::enable_if<is_builtin_integer<I>::value &&
+                                                                        is_builtin_integer<J>::value &&
+                                                                        !(std::is_same<I, Int>::value &&
+                                                                          std::is_same<J, Int>::value)>::type>
+    BasicRational(I x, J y) : BasicRational(checked::convert<Int>(x), checked::convert<Int>(y)) {}
+
+    // promotion to another backend, e.g. Rational -> Rational64 once int is too small;
+    // going back to a narrower one throws if the value does not fit
+    template<typename Other, bool OtherLazy>
+    explicit BasicRational(const BasicRational<Other, OtherLazy>& other) : a(checked::convert<Int>(other.numerator())),
+                                                                           b(checked::convert<Int>(other.denominator())) {
+        if (OtherLazy && !Lazy)
+            normalize();
+    }
+
+    static BasicRational from_raw(const Int& _a, const Int& _b) {
+        return BasicRational(_a, _b, raw_tag());
+    }
 };
 
+typedef BasicRational<int> Rational;
+typedef BasicRational<int64_t> Rational64;
+typedef BasicRational<__int128> Rational128;
+typedef BasicRational<BigInt> BigRational;
+typedef BasicRational<int, true> LazyRational;
+typedef BasicRational<int64_t, true> LazyRational64;
+
 // operators
 
-Rational operator+(const Rational& a, const Rational& b) {
-    return {a.numerator() * b.denominator() + b.numerator() * a.denominator(),
-            a.denominator() * b.denominator()};
+// a/b + c/d with g = gcd(b, d): (a * d/g + c * b/g) / (b/g * d), then only g can still divide
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> add_reduced_fractions(const BasicRational<Int, Lazy>& x, const BasicRational<Int, Lazy>& y) {
+    const Int& a = x.numerator();
+    const Int& b = x.denominator();
+    const Int& c = y.numerator();
+    const Int& d = y.denominator();
+    Int g = gcd_kernel(b, d);
+    if (g == 1)
+        return BasicRational<Int, Lazy>::from_raw(checked::add(checked::mul(a, d), checked::mul(c, b)),
+                                                  checked::mul(b, d));
+    Int t = checked::add(checked::mul(a, Int(d / g)), checked::mul(c, Int(b / g)));
+    Int g2 = gcd_kernel(t, g);
+    return BasicRational<Int, Lazy>::from_raw(Int(t / g2), checked::mul(Int(b / g), Int(d / g2)));
 }
 
-template<typename T, typename U>
-Rational operator+(const T& a, const U& b) {
-    return Rational(a) + Rational(b);
+// (a/b) * (c/d) = (a/g1 * c/g2) / (b/g2 * d/g1) with g1 = gcd(a, d), g2 = gcd(c, b)
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> multiply_reduced_fractions(const BasicRational<Int, Lazy>& x, const BasicRational<Int, Lazy>& y) {
+    const Int& a = x.numerator();
+    const Int& b = x.denominator();
+    const Int& c = y.numerator();
+    const Int& d = y.denominator();
+    Int g1 = gcd_kernel(a, d), g2 = gcd_kernel(c, b);
+    return BasicRational<Int, Lazy>::from_raw(checked::mul(Int(a / g1), Int(c / g2)),
+                                              checked::mul(Int(b / g2), Int(d / g1)));
 }
 
-Rational operator-(const Rational& a, const Rational& b) {
-    return {a.numerator() * b.denominator() - b.numerator() * a.denominator(),
-            a.denominator() * b.denominator()};
+// Lazy values try (a * d + c * b) / (b * d) first and reduce only if that overflows
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> add_fractions(const BasicRational<Int, Lazy>& x, const BasicRational<Int, Lazy>& y) {
+    if constexpr (Lazy) {
+        if constexpr (is_builtin_integer<Int>::value) {
+            Int ad, cb, num, den;
+            if (!__builtin_mul_overflow(x.numerator(), y.denominator(), &ad) &&
+                !__builtin_mul_overflow(y.numerator(), x.denominator(), &cb) &&
+                !__builtin_add_overflow(ad, cb, &num) &&
+                !__builtin_mul_overflow(x.denominator(), y.denominator(), &den))
+                return BasicRational<Int, Lazy>::from_raw(num, den);
+        } else {
+            return BasicRational<Int, Lazy>::from_raw(x.numerator() * y.denominator() + y.numerator() * x.denominator(),
+                                                      x.denominator() * y.denominator());
+        }
+        return add_reduced_fractions(x.reduced(), y.reduced());
+    }
+    return add_reduced_fractions(x, y);
 }
 
-template<typename T, typename U>
-Rational operator-(const T& a, const U& b) {
-    return Rational(a) - Rational(b);
+// Lazy values try (a * c) / (b * d) first and reduce only if that overflows
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> multiply_fractions(const BasicRational<Int, Lazy>& x, const BasicRational<Int, Lazy>& y) {
+    if constexpr (Lazy) {
+        if constexpr (is_builtin_integer<Int>::value) {
+            Int num, den;
+            if (!__builtin_mul_overflow(x.numerator(), y.numerator(), &num) &&
+                !__builtin_mul_overflow(x.denominator(), y.denominator(), &den))
+                return BasicRational<Int, Lazy>::from_raw(num, den);
+        } else {
+            return BasicRational<Int, Lazy>::from_raw(x.numerator() * y.numerator(), x.denominator() * y.denominator());
+        }
+        return multiply_reduced_fractions(x.reduced(), y.reduced());
+    }
+    return multiply_reduced_fractions(x, y);
 }
 
-Rational operator*(const Rational& a, const Rational& b) {
-    return {a.numerator() * b.numerator(),
-            a.denominator() * b.denominator()};
+// the mixed operators below take a Rational on one side and its integer type
+// (or a built-in integer) on the other; a floating operand would be truncated, so
+// Rational64(1, 3) + 0.5 does not compile. A built-in integer wider than Int is
+// range-checked: Rational(1, 3) + (1LL << 40) throws overflow_error
+template<typename Int, typename U>
+using mixed_rational_t = typename std::enable_if<std::is_same<U, Int>::value ||
+                                                 (is_builtin_integer<U>::value && std::is_convertible<U, Int>::value)>::type;
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator+(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return add_fractions(a, b);
 }
 
-template<typename T, typename U>
-Rational operator*(const T& a, const U& b) {
-    return Rational(a) * Rational(b);
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator+(const BasicRational<Int, Lazy>& a, const U& b) {
+    return add_fractions(a, BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(b), Int(1)));
 }
 
-Rational operator/(const Rational& a, const Rational& b) {
-    return {a.numerator() * b.denominator(),
-            a.denominator() * b.numerator()};
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator+(const U& a, const BasicRational<Int, Lazy>& b) {
+    return add_fractions(b, BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(a), Int(1)));
 }
 
-template<typename T, typename U>
-Rational operator/(const T& a, const U& b) {
-    return Rational(a) / Rational(b);
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator-(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return add_fractions(a, -b);
 }
 
-Rational operator+(const Rational& a) {
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator-(const BasicRational<Int, Lazy>& a, const U& b) {
+    return add_fractions(a, -BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(b), Int(1)));
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator-(const U& a, const BasicRational<Int, Lazy>& b) {
+    return add_fractions(-b, BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(a), Int(1)));
+}
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator*(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return multiply_fractions(a, b);
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator*(const BasicRational<Int, Lazy>& a, const U& b) {
+    return multiply_fractions(a, BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(b), Int(1)));
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator*(const U& a, const BasicRational<Int, Lazy>& b) {
+    return multiply_fractions(b, BasicRational<Int, Lazy>::from_raw(checked::convert<Int>(a), Int(1)));
+}
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator/(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    if (b.numerator() == 0)
+        throw std::domain_error("Rational: division by zero");
+    if (b.numerator() < 0)
+        return multiply_fractions(a, BasicRational<Int, Lazy>::from_raw(checked::sub(Int(0), b.denominator()), checked::sub(Int(0), b.numerator())));
+    return multiply_fractions(a, BasicRational<Int, Lazy>::from_raw(b.denominator(), b.numerator()));
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator/(const BasicRational<Int, Lazy>& a, const U& b) {
+    return a / BasicRational<Int, Lazy>(b);
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+BasicRational<Int, Lazy> operator/(const U& a, const BasicRational<Int, Lazy>& b) {
+    return BasicRational<Int, Lazy>(a) / b;
+}
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator+(const BasicRational<Int, Lazy>& a) {
     return a;
 }
 
-Rational operator-(const Rational& a) {
-    return {-a.numerator(), a.denominator()};
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator-(const BasicRational<Int, Lazy>& a) {
+    return BasicRational<Int, Lazy>::from_raw(checked::sub(Int(0), a.numerator()), a.denominator());
 }
 
-template<typename T>
-Rational& operator+=(Rational& a, const T& b) {
+template<typename Int, bool Lazy, typename U>
+BasicRational<Int, Lazy>& operator+=(BasicRational<Int, Lazy>& a, const U& b) {
     a = a + b;
     return a;
 }
 
-template<typename T>
-Rational& operator-=(Rational& a, const T& b) {
+template<typename Int, bool Lazy, typename U>
+BasicRational<Int, Lazy>& operator-=(BasicRational<Int, Lazy>& a, const U& b) {
     a = a - b;
     return a;
 }
 
-template<typename T>
-Rational& operator*=(Rational& a, const T& b) {
+template<typename Int, bool Lazy, typename U>
+BasicRational<Int, Lazy>& operator*=(BasicRational<Int, Lazy>& a, const U& b) {
     a = a * b;
     return a;
 }
 
-template<typename T>
-Rational& operator/=(Rational& a, const T& b) {
+template<typename Int, bool Lazy, typename U>
+BasicRational<Int, Lazy>& operator/=(BasicRational<Int, Lazy>& a, const U& b) {
     a = a / b;
     return a;
 }
 
-bool operator==(const Rational& a, const Rational& b) {
+template<typename Int, bool Lazy>
+bool operator==(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    if constexpr (Lazy) {
+        const BasicRational<Int, Lazy> x = a.reduced(), y = b.reduced();
+        return x.numerator() == y.numerator() &&
+               x.denominator() == y.denominator();
+    }
     return a.numerator() == b.numerator() &&
            a.denominator() == b.denominator();
 }
 
-template<typename T, typename U>
-bool operator==(const T& a, const U& b) {
-    return Rational(a) == Rational(b);
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+bool operator==(const BasicRational<Int, Lazy>& a, const U& b) {
+    // a value outside the range of Int is never equal to a fraction of Ints
+    return checked::fits<Int>(b) && a == BasicRational<Int, Lazy>::from_raw(Int(b), Int(1));
 }
 
-template<typename T, typename U>
-bool operator!=(const T& a, const U& b) {
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+bool operator==(const U& a, const BasicRational<Int, Lazy>& b) {
+    return b == a;
+}
+
+template<typename Int, bool Lazy>
+bool operator!=(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
     return !(a == b);
 }
 
-Rational& operator++(Rational& a) {
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+bool operator!=(const BasicRational<Int, Lazy>& a, const U& b) {
+    return !(a == b);
+}
+
+template<typename Int, bool Lazy, typename U, typename = mixed_rational_t<Int, U>>
+bool operator!=(const U& a, const BasicRational<Int, Lazy>& b) {
+    return !(b == a);
+}
+
+// denominators are positive, so a/b < c/d is a * d < c * b
+template<typename Int, bool Lazy>
+bool operator<(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    if constexpr (Lazy) {
+        const BasicRational<Int, Lazy> x = a.reduced(), y = b.reduced();
+        return checked::mul(x.numerator(), y.denominator()) < checked::mul(y.numerator(), x.denominator());
+    }
+    return checked::mul(a.numerator(), b.denominator()) < checked::mul(b.numerator(), a.denominator());
+}
+
+template<typename Int, bool Lazy>
+bool operator>(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return b < a;
+}
+
+template<typename Int, bool Lazy>
+bool operator<=(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return !(b < a);
+}
+
+template<typename Int, bool Lazy>
+bool operator>=(const BasicRational<Int, Lazy>& a, const BasicRational<Int, Lazy>& b) {
+    return !(a < b);
+}
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> abs(const BasicRational<Int, Lazy>& a) {
+    return a.numerator() < 0 ? -a : a;
+}
+
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy>& operator++(BasicRational<Int, Lazy>& a) {
     a += 1;
     return a;
 }
 
-Rational operator++(Rational& a, int) {
-    Rational old_a = a;
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator++(BasicRational<Int, Lazy>& a, int) {
+    BasicRational<Int, Lazy> old_a = a;
     a += 1;
     return old_a;
 }
 
-Rational& operator--(Rational& a) {
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy>& operator--(BasicRational<Int, Lazy>& a) {
     a -= 1;
     return a;
 }
 
-Rational operator--(Rational& a, int) {
-    Rational old_a = a;
+template<typename Int, bool Lazy>
+BasicRational<Int, Lazy> operator--(BasicRational<Int, Lazy>& a, int) {
+    BasicRational<Int, Lazy> old_a = a;
     a -= 1;
     return old_a;
 }
 
 #include <iostream>
 
-std::ostream& operator<<(std::ostream& out, Rational& a) {
-    a.normalize();
-    out << a.numerator();
-    if (a.denominator() != 1)
-       out << "/" << a.denominator();
+// streams know nothing about __int128
+template<typename Int>
+void print_integer(std::ostream& out, const Int& x) {
+    if constexpr (std::is_same<Int, __int128>::value) {
+        out << BigInt(x);
+    } else {
+        out << x;
+    }
+}
+
+template<typename Int, bool Lazy>
+std::ostream& operator<<(std::ostream& out, const BasicRational<Int, Lazy>& x) {
+    const BasicRational<Int, Lazy> a = x.reduced();
+    print_integer(out, a.numerator());
+    if (a.denominator() != 1) {
+        out << "/";
+        print_integer(out, a.denominator());
+    }
     return out;
 }
@@ -0,0 +1,365 @@
+#pragma once
+
+// Sparse matrices in compressed sparse row form: memory and time follow the
+// number of nonzero entries instead of n * m.
+// The compressed column form of A is the compressed row form of A^T, see transpose()
+
+namespace linal {
+    template <typename T>
+    class SparseMatrix {
+      private:
+        int n, m;
+        vector<size_t> start;   // line i holds entries start[i] .. start[i + 1] - 1
+        vector<int> index;      // column of every entry, increasing inside a line
+        vector<T> value;        // never zero
+
+        // a line of the eliminated matrix: (column, value) by increasing column
+        typedef vector<pair<int, T>> SparseLine;
+
+        // floating entries up to tol are rounding noise, see zero_tolerance()
+        static bool is_zero(const T& x, const T& tol = static_cast<T>(0)) {
+            if constexpr (is_floating_point<T>::value)
+                return abs(x) <= tol;
+            else
+                return x == static_cast<T>(0);
+        }
+
+        // state of Markowitz elimination: the pivot minimizes (r - 1)(c - 1), r and c the
+        // active entries of its line and column, which bounds the fill-in it can cause.
+        // The search is limited to the few columns with the fewest entries, where the
+        // cheap pivots usually are
+        struct Elimination {
+            static constexpr size_t search = 4;     // columns looked at for every pivot
+
+            vector<SparseLine> lines;
+            vector<vector<int>> lines_of;       // lines with an entry in the column, may hold stale ones
+            vector<size_t> count;               // entries of the column in active lines
+            vector<bool> active;                // line is not a pivot line yet
+            set<pair<size_t, int>> columns;     // (count, column) of columns with active entries
+            vector<pair<int, int>> pivots;      // (line, column) in elimination order
+            T tol;                              // smaller floating entries are dropped
+
+            static const T* find(const SparseLine& line, int col) {
+                auto it = lower_bound(line.begin(), line.end(), make_pair(col, static_cast<T>(0)),
+                                      [](const pair<int, T>& x, const pair<int, T>& y) { return x.first < y.first; });
+                return it != line.end() && it -> first == col ? &it -> second : nullptr;
+            }
+
+            void recount(int col, size_t new_count) {
+                if (count[col] != 0)
+                    columns.erase({count[col], col});
+                count[col] = new_count;
+                if (new_count != 0)
+                    columns.insert({new_count, col});
+            }
+
+            // line i -= f * line p, the entry in the pivot column is dropped rather than computed
+            void subtract(int i, const T& f, int p, int pivot_col) {
+                const SparseLine& x = lines[i];
+                const SparseLine& y = lines[p];
+                SparseLine ans;
+                ans.reserve(x.size() + y.size());
+                size_t k = 0, l = 0;
+                while (k != x.size() || l != y.size()) {
+                    if (l == y.size() || (k != x.size() && x[k].first < y[l].first)) {
+                        ans.push_back(x[k++]);
+                    } else if (k == x.size() || y[l].first < x[k].first) {
+                        int col = y[l].first;
+                        T cur = -(f * y[l++].second);
+                        if (is_zero(cur, tol))
+                            continue;
+                        ans.push_back({col, cur});
+                        lines_of[col].push_back(i);         // fill-in
+                        recount(col, count[col] + 1);
+                    } else {
+                        int col = x[k].first;
+                        T cur = x[k++].second - f * y[l++].second;
+                        if (col != pivot_col && !is_zero(cur, tol))
+                            ans.push_back({col, cur});
+                        else
+                            recount(col, count[col] - 1);   // cancellation
+                    }
+                }
+                lines[i].swap(ans);
+            }
+
+            explicit Elimination(const SparseMatrix& a)
+                : lines(a.n), lines_of(a.m), count(a.m), active(a.n, true), tol(a.zero_tolerance()) {
+                for (int i = 0; i != a.n; ++i)
+                    for (size_t k = a.start[i]; k != a.start[i + 1]; ++k) {
+                        if (is_zero(a.value[k], tol))
+                            continue;
+                        lines[i].push_back({a.index[k], a.value[k]});
+                        lines_of[a.index[k]].push_back(i);
+                        ++count[a.index[k]];
+                    }
+                for (int j = 0; j != a.m; ++j)
+                    if (count[j] != 0)
+                        columns.insert({count[j], j});
+                while (!columns.empty())
+                    step();
+            }
+
+            // floating pivots also have to be within a factor 10 of the largest active
+            // entry of their column (threshold pivoting), which keeps the elimination stable
+            void step() {
+                int p = -1, col = -1;
+                size_t best = numeric_limits<size_t>::max();
+                typedef typename conditional<is_floating_point<T>::value, T, double>::type Magnitude;
+                auto it = columns.begin();
+                for (size_t searched = 0; it != columns.end() && searched != search && best != 0; ++it, ++searched) {
+                    int j = it -> second;
+                    size_t c = it -> first;
+                    Magnitude largest = 0;
+                    if constexpr (is_floating_point<T>::value)
+                        for (int i : lines_of[j])
+                            if (active[i] && find(lines[i], j))
+                                largest = max(largest, abs(*find(lines[i], j)));
+                    for (int i : lines_of[j]) {
+                        if (!active[i])
+                            continue;
+                        const T* x = find(lines[i], j);
+                        if (!x)
+                            continue;
+                        if constexpr (is_floating_point<T>::value)
+                            if (abs(*x) < largest / 10)
+                                continue;
+                        size_t cost = (lines[i].size() - 1) * (c - 1);
+                        if (cost < best)
+                            best = cost, p = i, col = j;
+                    }
+                }
+                active[p] = false;
+                pivots.push_back({p, col});
+                for (const pair<int, T>& x : lines[p])
+                    recount(x.first, count[x.first] - 1);
+                T pivot = *find(lines[p], col);
+                vector<int> rest;
+                rest.swap(lines_of[col]);
+                for (int i : rest) {
+                    if (!active[i])
+                        continue;
+                    const T* x = find(lines[i], col);
+                    if (x)
+                        subtract(i, *x / pivot, p, col);
+                }
+            }
+        };
+
+      public:
+        // zero matrix
+        SparseMatrix(int _n = 0, int _m = -1) : n(_n), m(_m == -1 ? _n : _m), start(n + 1) {}
+
+        // from (line, column, value) triples in any order, repeated positions are summed
+        SparseMatrix(int _n, int _m, vector<tuple<int, int, T>> entries) : n(_n), m(_m), start(_n + 1) {
+            sort(entries.begin(), entries.end(), [](const tuple<int, int, T>& x, const tuple<int, int, T>& y) {
+                return make_pair(get<0>(x), get<1>(x)) < make_pair(get<0>(y), get<1>(y));
+            });
+            for (size_t k = 0; k != entries.size();) {
+                int i = get<0>(entries[k]), j = get<1>(entries[k]);
+                if (i < 0 || i >= n || j < 0 || j >= m)
+                    throw out_of_range("linal::SparseMatrix: entry outside of the matrix");
+                T sum = get<2>(entries[k]);
+                for (++k; k != entries.size() && get<0>(entries[k]) == i && get<1>(entries[k]) == j; ++k)
+                    sum += get<2>(entries[k]);
+                if (is_zero(sum))
+                    continue;
+                index.push_back(j);
+                value.push_back(sum);
+                ++start[i + 1];
+            }
+            for (int i = 0; i != n; ++i)
+                start[i + 1] += start[i];
+        }
+
+        explicit SparseMatrix(const Matrix<T>& a) : n(a.size().first), m(a.size().second), start(1) {
+            for (int i = 0; i != n; ++i) {
+                for (int j = 0; j != m; ++j)
+                    if (!is_zero(a[i][j])) {
+                        index.push_back(j);
+                        value.push_back(a[i][j]);
+                    }
+                start.push_back(index.size());
+            }
+        }
+
+        Matrix<T> to_dense() const {
+            Matrix<T> ans(n, m);
+            for (int i = 0; i != n; ++i)
+                for (size_t k = start[i]; k != start[i + 1]; ++k)
+                    ans[i][index[k]] = value[k];
+            return ans;
+        }
+
+        // {lines, columns}
+        pair<int, int> size() const {
+            return {n, m};
+        }
+
+        size_t nonzeros() const {
+            return value.size();
+        }
+
+        // the compressed arrays
+        const vector<size_t>& line_starts() const {
+            return start;
+        }
+
+        const vector<int>& column_indices() const {
+            return index;
+        }
+
+        const vector<T>& values() const {
+            return value;
+        }
+
+        // counting sort by column, O(n + m + nonzeros)
+        SparseMatrix transpose() const {
+            SparseMatrix ans(m, n);
+            ans.index.resize(index.size());
+            ans.value.resize(value.size());
+            for (int j : index)
+                ++ans.start[j + 1];
+            for (int j = 0; j != m; ++j)
+                ans.start[j + 1] += ans.start[j];
+            vector<size_t> pos(ans.start.begin(), ans.start.end() - 1);
+            for (int i = 0; i != n; ++i)
+                for (size_t k = start[i]; k != start[i + 1]; ++k) {
+                    size_t& to = pos[index[k]];
+                    ans.index[to] = i;
+                    ans.value[to++] = value[k];
+                }
+            return ans;
+        }
+
+        vector<T> operator*(const vector<T>& x) const {
+            return multiply(x, execution::seq);
+        }
+
+        // sparse matrix times dense vector, lines are split between threads
+        vector<T> multiply(const vector<T>& x, const ExecutionPolicy& policy) const {
+            if (x.size() != static_cast<size_t>(m))
+                throw invalid_argument("linal::SparseMatrix: vector has wrong size");
+            vector<T> ans(n, static_cast<T>(0));
+            parallel_for(policy, 0, n, 4096, [&](size_t l, size_t r) {
+                for (size_t i = l; i != r; ++i) {
+                    T sum = static_cast<T>(0);
+                    for (size_t k = start[i]; k != start[i + 1]; ++k)
+                        sum += value[k] * x[index[k]];
+                    ans[i] = sum;
+                }
+            });
+            return ans;
+        }
+
+        SparseMatrix operator*(const SparseMatrix& other) const {
+            return multiply(other, execution::seq);
+        }
+
+        // Gustavson: every line of the product is accumulated in a dense buffer
+        // indexed by column, only the touched columns are visited afterwards
+        SparseMatrix multiply(const SparseMatrix& other, const ExecutionPolicy& policy) const {
+            if (m != other.n)
+                throw invalid_argument("linal::SparseMatrix: sizes do not match");
+            vector<SparseLine> lines(n);
+            parallel_for(policy, 0, n, 1024, [&](size_t l, size_t r) {
+                vector<T> acc(other.m, static_cast<T>(0));
+                vector<bool> touched(other.m);
+                vector<int> cols;
+                for (size_t i = l; i != r; ++i) {
+                    for (size_t k = start[i]; k != start[i + 1]; ++k)
+                        for (size_t t = other.start[index[k]]; t != other.start[index[k] + 1]; ++t) {
+                            int j = other.index[t];
+                            if (!touched[j]) {
+                                touched[j] = true;
+                                cols.push_back(j);
+                            }
+                            acc[j] += value[k] * other.value[t];
+                        }
+                    sort(cols.begin(), cols.end());
+                    for (int j : cols) {
+                        if (!is_zero(acc[j]))
+                            lines[i].push_back({j, acc[j]});
+                        acc[j] = static_cast<T>(0);
+                        touched[j] = false;
+                    }
+                    cols.clear();
+                }
+            });
+            SparseMatrix ans(n, other.m);
+            for (int i = 0; i != n; ++i) {
+                for (const pair<int, T>& x : lines[i]) {
+                    ans.index.push_back(x.first);
+                    ans.value.push_back(x.second);
+                }
+                ans.start[i + 1] = ans.index.size();
+                SparseLine().swap(lines[i]);
+            }
+            return ans;
+        }
+
+        // as Matrix::zero_tolerance(): n * m machine epsilons of the largest line sum for
+        // floating T, entries below it after elimination are rounding noise; 0 otherwise
+        T zero_tolerance() const {
+            T norm = static_cast<T>(0);
+            if constexpr (is_floating_point<T>::value) {
+                for (int i = 0; i != n; ++i) {
+                    T sum = 0;
+                    for (size_t k = start[i]; k != start[i + 1]; ++k)
+                        sum += abs(value[k]);
+                    norm = max(norm, sum);
+                }
+                norm *= T(n) * m * numeric_limits<T>::epsilon();
+            }
+            return norm;
+        }
+
+        // T has to be a field; floating entries below zero_tolerance() do not count
+        size_t rk() const {
+            return Elimination(*this).pivots.size();
+        }
+
+        // fundamental system of solutions as columns, like Matrix::ker().
+        // Pivot lines form a triangular system in elimination order: a pivot line has no
+        // entries in the columns pivoted before it, so every free column is solved backwards.
+        // Each solve reads every pivot line, the back substitution costs
+        // O(free columns * entries of the pivot lines) after the elimination
+        SparseMatrix ker() const {
+            Elimination e(*this);
+            vector<int> line_of(m, -1);
+            for (const pair<int, int>& p : e.pivots)
+                line_of[p.second] = p.first;
+            vector<tuple<int, int, T>> entries;
+            vector<T> x(m, static_cast<T>(0));
+            vector<int> nonzero;
+            int k = 0;
+            for (int f = 0; f != m; ++f) {
+                if (line_of[f] != -1)
+                    continue;
+                x[f] = static_cast<T>(1);
+                nonzero.push_back(f);
+                for (size_t t = e.pivots.size(); t-- != 0;) {
+                    int col = e.pivots[t].second;
+                    T sum = static_cast<T>(0), pivot = static_cast<T>(0);
+                    for (const pair<int, T>& y : e.lines[e.pivots[t].first]) {
+                        if (y.first == col)
+                            pivot = y.second;
+                        else if (!is_zero(x[y.first]))
+                            sum += y.second * x[y.first];
+                    }
+                    if (!is_zero(sum)) {
+                        x[col] = -sum / pivot;
+                        nonzero.push_back(col);
+                    }
+                }
+                for (int j : nonzero) {
+                    entries.emplace_back(j, k, x[j]);
+                    x[j] = static_cast<T>(0);
+                }
+                nonzero.clear();
+                ++k;
+            }
+            return SparseMatrix(m, k, entries);
+        }
+    };
+}
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "instrumentation.h"
+
+// Strassen-Winograd multiplication for scalars whose products are expensive
+// (fractions, big integers): a level does 7 half-size products and 15 additions
+// instead of 8 products. C = A * B, where A is n x k, B is k x m and C is n x m,
+// all row-major with line distances lda, ldb and ldc.
+// Odd sizes are peeled rather than padded: the even part is recursed on and the
+// last line, column and inner index are added by the classical loop. Temporaries
+// of every level are carved from one buffer allocated before the recursion.
+
+namespace linal {
+    namespace strassen {
+        // products with a dimension up to this go to the classical loop; tunable
+        inline size_t cutover = 48;
+
+        namespace detail {
+            inline bool classical_size(size_t n, size_t m, size_t k) {
+                return std::min({n, m, k}) <= std::max<size_t>(cutover, 1);
+            }
+
+            // z = x + y, z may be x or y
+            template <typename T>
+            void add(size_t n, size_t m, const T* x, size_t ldx, const T* y, size_t ldy, T* z, size_t ldz) {
+                for (size_t i = 0; i != n; ++i)
+                    for (size_t j = 0; j != m; ++j)
+                        z[i * ldz + j] = x[i * ldx + j] + y[i * ldy + j];
+            }
+
+            // z = x - y, z may be x or y
+            template <typename T>
+            void sub(size_t n, size_t m, const T* x, size_t ldx, const T* y, size_t ldy, T* z, size_t ldz) {
+                for (size_t i = 0; i != n; ++i)
+                    for (size_t j = 0; j != m; ++j)
+                        z[i * ldz + j] = x[i * ldx + j] - y[i * ldy + j];
+            }
+
+            // c (+)= a * b in i-k-j order, zero entries of a are skipped
+            template <typename T>
+            void classical(size_t n, size_t m, size_t k, const T* a, size_t lda, const T* b, size_t ldb,
+                           T* c, size_t ldc, bool accumulate) {
+                for (size_t i = 0; i != n; ++i) {
+                    T* res = c + i * ldc;
+                    if (!accumulate)
+                        std::fill(res, res + m, static_cast<T>(0));
+                    for (size_t t = 0; t != k; ++t) {
+                        const T& x = a[i * lda + t];
+                        if (x == static_cast<T>(0))
+                            continue;
+                        LINAL_COUNT(multiplications, m);
+                        const T* line = b + t * ldb;
+                        for (size_t j = 0; j != m; ++j)
+                            res[j] += x * line[j];
+                    }
+                }
+            }
+
+            // temporaries of a level: S (hn x hk, later P1: hn x hm) and T (hk x hm)
+            inline size_t scratch(size_t n, size_t m, size_t k) {
+                if (classical_size(n, m, k))
+                    return 0;
+                size_t hn = n / 2, hm = m / 2, hk = k / 2;
+                return hn * std::max(hk, hm) + hk * hm + scratch(hn, hm, hk);
+            }
+
+            template <typename T>
+            void multiply(size_t n, size_t m, size_t k, const T* a, size_t lda, const T* b, size_t ldb,
+                          T* c, size_t ldc, T* pool) {
+                if (classical_size(n, m, k)) {
+                    classical(n, m, k, a, lda, b, ldb, c, ldc, false);
+                    return;
+                }
+                size_t hn = n / 2, hm = m / 2, hk = k / 2;
+                const T *a11 = a, *a12 = a + hk, *a21 = a + hn * lda, *a22 = a21 + hk;
+                const T *b11 = b, *b12 = b + hm, *b21 = b + hk * ldb, *b22 = b21 + hm;
+                T *c11 = c, *c12 = c + hm, *c21 = c + hn * ldc, *c22 = c21 + hm;
+                T* x = pool;
+                T* y = x + hn * std::max(hk, hm);
+                T* rest = y + hk * hm;
+                // the schedule of Boyer, Dumas, Pernet and Zhou: two temporaries,
+                // the quadrants of C hold the other intermediate products
+                sub(hn, hk, a11, lda, a21, lda, x, hk);                 // S3 = A11 - A21
+                sub(hk, hm, b22, ldb, b12, ldb, y, hm);                 // T3 = B22 - B12
+                multiply(hn, hm, hk, x, hk, y, hm, c21, ldc, rest);     // P7 = S3 T3
+                add(hn, hk, a21, lda, a22, lda, x, hk);                 // S1 = A21 + A22
+                sub(hk, hm, b12, ldb, b11, ldb, y, hm);                 // T1 = B12 - B11
+                multiply(hn, hm, hk, x, hk, y, hm, c22, ldc, rest);     // P5 = S1 T1
+                sub(hn, hk, x, hk, a11, lda, x, hk);                    // S2 = S1 - A11
+                sub(hk, hm, b22, ldb, y, hm, y, hm);                    // T2 = B22 - T1
+                multiply(hn, hm, hk, x, hk, y, hm, c12, ldc, rest);     // P6 = S2 T2
+                sub(hn, hk, a12, lda, x, hk, x, hk);                    // S4 = A12 - S2
+                multiply(hn, hm, hk, x, hk, b22, ldb, c11, ldc, rest);  // P3 = S4 B22
+                multiply(hn, hm, hk, a11, lda, b11, ldb, x, hm, rest);  // P1 = A11 B11
+                add(hn, hm, x, hm, c12, ldc, c12, ldc);                 // U2 = P1 + P6
+                add(hn, hm, c12, ldc, c21, ldc, c21, ldc);              // U3 = U2 + P7
+                add(hn, hm, c12, ldc, c22, ldc, c12, ldc);              // U4 = U2 + P5
+                add(hn, hm, c21, ldc, c22, ldc, c22, ldc);              // U7 = U3 + P5 = C22
+                add(hn, hm, c12, ldc, c11, ldc, c12, ldc);              // U5 = U4 + P3 = C12
+                sub(hk, hm, y, hm, b21, ldb, y, hm);                    // T4 = T2 - B21
+                multiply(hn, hm, hk, a22, lda, y, hm, c11, ldc, rest);  // P4 = A22 T4
+                sub(hn, hm, c21, ldc, c11, ldc, c21, ldc);              // U6 = U3 - P4 = C21
+                multiply(hn, hm, hk, a12, lda, b21, ldb, c11, ldc, rest); // P2 = A12 B21
+                add(hn, hm, x, hm, c11, ldc, c11, ldc);                 // U1 = P1 + P2 = C11
+                // peeling: the even part is done, the odd leftovers are thin products
+                size_t n2 = 2 * hn, m2 = 2 * hm, k2 = 2 * hk;
+                if (k2 != k)
+                    classical(n2, m2, 1, a + k2, lda, b + k2 * ldb, ldb, c, ldc, true);
+                if (m2 != m)
+                    classical(n2, 1, k, a, lda, b + m2, ldb, c + m2, ldc, false);
+                if (n2 != n)
+                    classical(1, m, k, a + n2 * lda, lda, b, ldb, c + n2 * ldc, ldc, false);
+            }
+        }
+
+        // C = A * B
+        template <typename T>
+        void multiply(size_t n, size_t m, size_t k, const T* a, size_t lda, const T* b, size_t ldb, T* c, size_t ldc) {
+            std::vector<T> pool(detail::scratch(n, m, k));
+            detail::multiply(n, m, k, a, lda, b, ldb, c, ldc, pool.data());
+        }
+    }
+}
@@ -0,0 +1,40 @@
+// 007: Hessenberg and Berkowitz against det(A - xI) expanded by definition
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(7);
+
+    void by_definition() {
+        for (size_t n = 1; n != 7; ++n) {
+            Matrix<long long> a = test::random_matrix<long long>(n, n, 4, rng);
+            CHECK(a.characteristic_polynomial() == a.characteristic_polynomial_by_definition());
+            Matrix<Rational64> r = test::random_matrix<Rational64>(n, n, 4, rng);
+            CHECK(r.characteristic_polynomial() == r.characteristic_polynomial_by_definition());
+        }
+    }
+
+    // past the sizes the definition can reach: p(A) = 0 and p has degree n
+    void cayley_hamilton() {
+        for (size_t n = 7; n != 13; ++n) {
+            Matrix<BigInt> a = test::random_matrix<BigInt>(n, n, 9, rng);
+            Polynomial<BigInt> p = a.characteristic_polynomial();
+            CHECK(p.Degree() == int(n));
+            Matrix<BigInt> value(n);
+            for (int k = p.Degree(); k >= 0; --k) {
+                value = value * a;
+                for (size_t i = 0; i != n; ++i)
+                    value[i][i] += p.get()[k];
+            }
+            CHECK(test::equal(value, Matrix<BigInt>(n)));
+        }
+    }
+}
+
+int main() {
+    by_definition();
+    cayley_hamilton();
+    return test::result();
+}
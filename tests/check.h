@@ -0,0 +1,91 @@
+#pragma once
+
+// Every test compares a fast path with the plain algorithm it replaced on random
+// inputs. A failed CHECK prints where it failed, the test then exits with 1
+
+#include "../linal.h"
+
+namespace test {
+    inline int& failures() {
+        static int count = 0;
+        return count;
+    }
+
+    inline int result() {
+        if (failures() != 0)
+            cerr << failures() << " checks failed\n";
+        return failures() != 0;
+    }
+
+    // entries in [-range, range]
+    template <typename T>
+    linal::Matrix<T> random_matrix(size_t n, size_t m, int range, mt19937& rng) {
+        linal::Matrix<T> a(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                a[i][j] = T(int(rng() % (2 * range + 1)) - range);
+        return a;
+    }
+
+    // rank at most r: a product of n x r and r x m factors
+    template <typename T>
+    linal::Matrix<T> low_rank_matrix(size_t n, size_t m, size_t r, mt19937& rng) {
+        return linal::Matrix<T>(random_matrix<T>(n, r, 3, rng) * random_matrix<T>(r, m, 3, rng));
+    }
+
+    inline Permutation random_permutation(size_t n, mt19937& rng) {
+        Permutation p(n);
+        for (size_t i = n; i > 1; --i)
+            swap(p[i - 1], p[rng() % i]);
+        return p;
+    }
+
+    template <typename T>
+    bool equal(const linal::Matrix<T>& a, const linal::Matrix<T>& b) {
+        if (a.size() != b.size())
+            return false;
+        for (int i = 0; i != a.size().first; ++i)
+            for (int j = 0; j != a.size().second; ++j)
+                if (!(a[i][j] == b[i][j]))
+                    return false;
+        return true;
+    }
+
+    // entrywise, relative to the largest entry of b
+    inline bool close(const linal::Matrix<double>& a, const linal::Matrix<double>& b, double eps = 1e-9) {
+        if (a.size() != b.size())
+            return false;
+        double norm = 1;
+        for (int i = 0; i != b.size().first; ++i)
+            for (int j = 0; j != b.size().second; ++j)
+                norm = max(norm, abs(b[i][j]));
+        for (int i = 0; i != a.size().first; ++i)
+            for (int j = 0; j != a.size().second; ++j)
+                if (abs(a[i][j] - b[i][j]) > eps * norm)
+                    return false;
+        return true;
+    }
+
+    // i-j-k by definition
+    template <typename T>
+    linal::Matrix<T> naive_product(const linal::Matrix<T>& a, const linal::Matrix<T>& b) {
+        size_t n = a.size().first, k = a.size().second, m = b.size().second;
+        linal::Matrix<T> ans(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j) {
+                T sum = static_cast<T>(0);
+                for (size_t t = 0; t != k; ++t)
+                    sum += a[i][t] * b[t][j];
+                ans[i][j] = sum;
+            }
+        return ans;
+    }
+}
+
+#define CHECK(condition)                                                                    \
+    do {                                                                                    \
+        if (!(condition)) {                                                                 \
+            cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n";      \
+            ++test::failures();                                                             \
+        }                                                                                   \
+    } while (0)
@@ -0,0 +1,34 @@
+// 004: Bareiss and pivoted LU against the definition
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(4);
+
+    void determinants() {
+        for (size_t n = 0; n != 8; ++n)
+            for (int t = 0; t != 5; ++t) {
+                Matrix<long long> a = test::random_matrix<long long>(n, n, 5, rng);
+                long long expected = a.det_by_definition();
+                CHECK(a.det() == expected);
+                CHECK(a.det_bareiss() == expected);
+                Matrix<Rational64> r(a.size().first, a.size().second);
+                Matrix<double> d(a.size().first, a.size().second);
+                for (size_t i = 0; i != n; ++i)
+                    for (size_t j = 0; j != n; ++j)
+                        r[i][j] = a[i][j], d[i][j] = a[i][j];
+                CHECK(r.det() == Rational64(expected));
+                CHECK(r.det_lu() == Rational64(expected));
+                CHECK(abs(d.det() - expected) <= 1e-9 * max(1.0, abs(double(expected))));
+            }
+        Matrix<long long> singular = test::low_rank_matrix<long long>(6, 6, 4, rng);
+        CHECK(singular.det() == 0);
+    }
+}
+
+int main() {
+    determinants();
+    return test::result();
+}
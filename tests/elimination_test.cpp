@@ -0,0 +1,51 @@
+// 008: elimination in the scalar type; fractions reduce, integers are eliminated
+// fraction-free, both against exact BigRational elimination
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(8);
+
+    template <typename T>
+    Matrix<T> convert(const Matrix<long long>& a) {
+        Matrix<T> ans(a.size().first, a.size().second);
+        for (int i = 0; i != a.size().first; ++i)
+            for (int j = 0; j != a.size().second; ++j)
+                ans[i][j] = T(a[i][j]);
+        return ans;
+    }
+
+    void integer_rank() {
+        CHECK(Matrix<long long>(vector<vector<long long>>{{2, 3}, {4, 6}}).rk() == 1);
+        CHECK(Matrix<int>(vector<vector<int>>{{2, 3}, {4, 6}}).rk() == 1);
+        for (int t = 0; t != 200; ++t) {
+            size_t n = rng() % 9 + 1, m = rng() % 9 + 1, r = rng() % 5 + 1;
+            Matrix<long long> a = t % 2 ? test::low_rank_matrix<long long>(n, m, r, rng)
+                                        : test::random_matrix<long long>(n, m, 2, rng);
+            size_t rank = convert<BigRational>(a).rk();
+            CHECK(a.rk() == rank);
+            CHECK(a.rk(linal::execution::par(4)) == rank);
+            CHECK(convert<BigInt>(a).rk() == rank);
+        }
+    }
+
+    void fraction_gauss() {
+        for (int t = 0; t != 50; ++t) {
+            size_t n = rng() % 7 + 1, m = rng() % 7 + 1, r = rng() % 4 + 1;
+            Matrix<long long> a = test::low_rank_matrix<long long>(n, m, r, rng);
+            Matrix<Rational64> g = convert<Rational64>(a).gauss();
+            Matrix<BigRational> expected = convert<BigRational>(a).gauss();
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    CHECK(BigRational(BigInt(g[i][j].numerator()), BigInt(g[i][j].denominator())) == expected[i][j]);
+        }
+    }
+}
+
+int main() {
+    integer_rank();
+    fraction_gauss();
+    return test::result();
+}
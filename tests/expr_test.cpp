@@ -0,0 +1,79 @@
+// 018: fused expression evaluation against entrywise loops, including expressions
+// that read the matrix they are assigned to
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(18);
+
+    template <typename T, typename F>
+    Matrix<T> entrywise(size_t n, size_t m, F f) {
+        Matrix<T> ans(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                ans[i][j] = f(i, j);
+        return ans;
+    }
+
+    void fused() {
+        for (int t = 0; t != 30; ++t) {
+            size_t n = rng() % 50 + 1, m = rng() % 50 + 1;
+            Matrix<long long> a = test::random_matrix<long long>(n, m, 9, rng), b = test::random_matrix<long long>(n, m, 9, rng),
+                              c = test::random_matrix<long long>(m, n, 9, rng), s = test::random_matrix<long long>(n, n, 9, rng);
+            Matrix<long long> sum = a + b, difference = a - b, scaled = 3 * a - b * 2, negated = -a;
+            CHECK(test::equal(sum, entrywise<long long>(n, m, [&](size_t i, size_t j) { return a[i][j] + b[i][j]; })));
+            CHECK(test::equal(difference, entrywise<long long>(n, m, [&](size_t i, size_t j) { return a[i][j] - b[i][j]; })));
+            CHECK(test::equal(scaled, entrywise<long long>(n, m, [&](size_t i, size_t j) { return 3 * a[i][j] - 2 * b[i][j]; })));
+            CHECK(test::equal(negated, entrywise<long long>(n, m, [&](size_t i, size_t j) { return -a[i][j]; })));
+            Matrix<long long> mixed = a + c.transpose() - 2 * b;
+            CHECK(test::equal(mixed, entrywise<long long>(n, m, [&](size_t i, size_t j) { return a[i][j] + c[j][i] - 2 * b[i][j]; })));
+            Matrix<long long> shifted = s - linal::identity(n, 5LL), plus = linal::identity<long long>(n) + s.transpose();
+            CHECK(test::equal(shifted, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[i][j] - (i == j ? 5 : 0); })));
+            CHECK(test::equal(plus, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[j][i] + (i == j ? 1 : 0); })));
+            // products of expressions are evaluated once and handed to GEMM
+            Matrix<long long> sum_copy = a + b;
+            CHECK(test::equal((a + b) * c, test::naive_product(sum_copy, c)));
+            CHECK(test::equal(c.transpose() * a.transpose(), Matrix<long long>((a * c).transpose())));
+            Matrix<double> x = test::random_matrix<double>(n, m, 9, rng);
+            CHECK(test::close(x.transpose() * x, test::naive_product(Matrix<double>(x.transpose()), x)));
+        }
+    }
+
+    // operands are held by reference, so these read entries of the target
+    void aliasing() {
+        for (int t = 0; t != 30; ++t) {
+            size_t n = rng() % 50 + 1, m = rng() % 50 + 1;
+            Matrix<long long> s = test::random_matrix<long long>(n, n, 9, rng), a = test::random_matrix<long long>(n, m, 9, rng),
+                              b = test::random_matrix<long long>(m, m, 9, rng);
+            Matrix<long long> x = s;
+            x = x.transpose();
+            CHECK(test::equal(x, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[j][i]; })));
+            x = a;
+            x = x.transpose();
+            CHECK(test::equal(x, entrywise<long long>(m, n, [&](size_t i, size_t j) { return a[j][i]; })));
+            x = a;
+            x = x * b + x;
+            CHECK(test::equal(x, Matrix<long long>(test::naive_product(a, b) + a)));
+            x = s;
+            x += x.transpose();
+            CHECK(test::equal(x, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[i][j] + s[j][i]; })));
+            x = s;
+            x -= 2 * x.transpose();
+            CHECK(test::equal(x, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[i][j] - 2 * s[j][i]; })));
+            x = s;
+            x = x.transpose() - x + linal::identity(n, 7LL);
+            CHECK(test::equal(x, entrywise<long long>(n, n, [&](size_t i, size_t j) { return s[j][i] - s[i][j] + (i == j ? 7 : 0); })));
+            x = s;
+            x = 3 * x - x;
+            CHECK(test::equal(x, entrywise<long long>(n, n, [&](size_t i, size_t j) { return 2 * s[i][j]; })));
+        }
+    }
+}
+
+int main() {
+    fused();
+    aliasing();
+    return test::result();
+}
@@ -0,0 +1,73 @@
+// 019: compile-time sized matrices against the dynamic Matrix
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(19);
+
+    // everything below is evaluated by the compiler
+    constexpr Matrix<long long, 2> rotation{{0, -1}, {1, 0}};
+    constexpr Matrix<long long, 3> upper{{2, 1, 0}, {0, 3, 1}, {0, 0, 4}};
+    constexpr Matrix<long long, 4> fours{{1, 2, 0, 1}, {0, 1, 3, 0}, {2, 0, 1, 1}, {1, 1, 0, 2}};
+    static_assert(rotation.det() == 1 && upper.det() == 24, "");
+    static_assert(fours.det() == 16, "");
+    static_assert((rotation ^ 4) == Matrix<long long, 2>{{1, 0}, {0, 1}}, "");
+    static_assert(rotation * rotation == -Matrix<long long, 2>{{1, 0}, {0, 1}}, "");
+    static_assert((upper * upper.transpose())[1][1] == 10, "");
+    static_assert(Matrix<double, 2>{{1, 1}, {1, 2}}.inverse() == Matrix<double, 2>{{2, -1}, {-1, 1}}, "");
+
+    template <typename T, int N, int M>
+    Matrix<T, N, M> random_fixed(int range) {
+        return Matrix<T, N, M>(test::random_matrix<T>(N, M, range, rng));
+    }
+
+    // N x M times M x P, unrolled up to 64 multiplications and looped above
+    template <int N, int M, int P>
+    void product() {
+        for (int t = 0; t != 10; ++t) {
+            Matrix<long long, N, M> a = random_fixed<long long, N, M>(9);
+            Matrix<long long, M, P> b = random_fixed<long long, M, P>(9);
+            CHECK(test::equal(Matrix<long long>(a * b), Matrix<long long>(a) * Matrix<long long>(b)));
+            CHECK(test::equal(Matrix<long long>(a.transpose()), Matrix<long long>(Matrix<long long>(a).transpose())));
+        }
+    }
+
+    template <int N>
+    void square() {
+        for (int t = 0; t != 20; ++t) {
+            Matrix<long long, N> a = random_fixed<long long, N, N>(5);
+            Matrix<long long> d(a);
+            CHECK(a.det() == d.det_by_definition());
+            CHECK(test::equal(Matrix<long long>(a ^ 5), Matrix<long long>(d ^ 5)));
+            Matrix<Rational64, N> r = random_fixed<Rational64, N, N>(5);
+            Matrix<Rational64> dr(r);
+            if (dr.det() == Rational64(0))
+                continue;
+            CHECK(test::equal(Matrix<Rational64>(r.inverse()), dr.inverse()));
+            CHECK(r * r.inverse() == (Matrix<Rational64, N>(Matrix<Rational64>(N) ^ 0)));
+        }
+        Matrix<Rational64, N> zero;
+        bool thrown = false;
+        try {
+            zero.inverse();
+        } catch (const domain_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+}
+
+int main() {
+    product<2, 2, 2>();
+    product<3, 4, 2>();
+    product<4, 4, 4>();
+    product<5, 6, 3>();
+    square<1>();
+    square<2>();
+    square<3>();
+    square<4>();
+    square<5>();
+    return test::result();
+}
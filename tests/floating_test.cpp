@@ -0,0 +1,61 @@
+// 016: the pivoted, blocked floating path against exact elimination
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(16);
+
+    void rank_and_kernel() {
+        for (int t = 0; t != 20; ++t) {
+            // past one 64-column panel now and then
+            size_t n = rng() % (t % 4 ? 40 : 150) + 1, m = rng() % (t % 4 ? 40 : 150) + 1, r = rng() % 6 + 1;
+            Matrix<long long> a = test::low_rank_matrix<long long>(n, m, r, rng);
+            Matrix<BigRational> exact(n, m);
+            Matrix<double> d(n, m);
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    exact[i][j] = BigRational(a[i][j]), d[i][j] = a[i][j];
+            size_t rank = exact.rk();
+            CHECK(d.rk() == rank);
+            CHECK(d.rk(linal::execution::par(4)) == rank);
+            Matrix<double> k = d.ker();
+            CHECK(k.size().second == int(m - rank));
+            if (k.size().second != 0)
+                CHECK(test::close(d * k, Matrix<double>(n, k.size().second), 1e-9));
+        }
+    }
+
+    // full rank, so the reduced form is the identity next to A^-1 B
+    void reduced_form() {
+        for (int t = 0; t != 10; ++t) {
+            size_t n = rng() % 100 + 1, extra = rng() % 5;
+            Matrix<double> a = test::random_matrix<double>(n, n + extra, 9, rng);
+            Matrix<double> g = a.gauss(), p = a.gauss(linal::execution::par(4));
+            Matrix<double> left(n, n), right(n, extra);
+            for (size_t i = 0; i != n; ++i) {
+                for (size_t j = 0; j != n; ++j)
+                    left[i][j] = g[i][j];
+                for (size_t j = 0; j != extra; ++j)
+                    right[i][j] = a[i][n + j];
+            }
+            CHECK(test::close(left, Matrix<double>(n) ^ 0, 1e-9));
+            CHECK(test::close(g, p, 1e-9));
+            Matrix<double> square(n, n), rest(n, extra);
+            for (size_t i = 0; i != n; ++i) {
+                for (size_t j = 0; j != n; ++j)
+                    square[i][j] = a[i][j];
+                for (size_t j = 0; j != extra; ++j)
+                    rest[i][j] = g[i][n + j];
+            }
+            CHECK(test::close(square * rest, right, 1e-8));
+        }
+    }
+}
+
+int main() {
+    rank_and_kernel();
+    reduced_form();
+    return test::result();
+}
@@ -0,0 +1,47 @@
+// 002: the blocked GEMM kernel behind Matrix::operator* against the naive loop
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(2);
+
+    // long long and int64_t are distinct types on LP64 targets, both reach the kernel
+    static_assert(linal::is_gemm_scalar<long long>::value && linal::is_gemm_scalar<int64_t>::value, "");
+    static_assert(linal::is_gemm_scalar<int32_t>::value && linal::is_gemm_scalar<double>::value, "");
+
+    template <typename T>
+    void exact_products(size_t max_size) {
+        for (int t = 0; t != 20; ++t) {
+            size_t n = rng() % max_size + 1, k = rng() % max_size + 1, m = rng() % max_size + 1;
+            Matrix<T> a = test::random_matrix<T>(n, k, 9, rng), b = test::random_matrix<T>(k, m, 9, rng);
+            CHECK(test::equal(a * b, test::naive_product(a, b)));
+            CHECK(test::equal(a.mul(b, linal::execution::par(4)), test::naive_product(a, b)));
+        }
+    }
+
+    void floating_products() {
+        for (int t = 0; t != 30; ++t) {
+            size_t n = rng() % 70 + 1, k = rng() % 70 + 1, m = rng() % 70 + 1;
+            Matrix<double> x = test::random_matrix<double>(n, k, 9, rng), y = test::random_matrix<double>(k, m, 9, rng);
+            CHECK(test::close(x * y, test::naive_product(x, y)));
+            CHECK(test::close(x.mul(y, linal::execution::par(4)), test::naive_product(x, y)));
+        }
+    }
+
+    // past one KC x MC block of the packed panels
+    void large_product() {
+        Matrix<int64_t> a = test::random_matrix<int64_t>(300, 270, 9, rng), b = test::random_matrix<int64_t>(270, 290, 9, rng);
+        CHECK(test::equal(a * b, test::naive_product(a, b)));
+    }
+}
+
+int main() {
+    exact_products<int64_t>(70);
+    exact_products<long long>(70);
+    exact_products<int32_t>(70);
+    floating_products();
+    large_product();
+    return test::result();
+}
@@ -0,0 +1,37 @@
+// 006: Gauss-Jordan inverse against the identity and the LU solves
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(6);
+
+    template <typename T>
+    void inverses() {
+        for (int t = 0; t != 20; ++t) {
+            size_t n = rng() % 8 + 1;
+            Matrix<T> a = test::random_matrix<T>(n, n, 4, rng);
+            if (a.det() == T(0))
+                continue;
+            Matrix<T> id = Matrix<T>(n) ^ 0;
+            Matrix<T> inv = a.inverse();
+            CHECK(test::equal(a * inv, id));
+            CHECK(test::equal(inv * a, id));
+            CHECK(test::equal(linal::LU<T>(a).inverse(), inv));
+        }
+        bool thrown = false;
+        try {
+            test::low_rank_matrix<T>(5, 5, 3, rng).inverse();
+        } catch (const domain_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+}
+
+int main() {
+    inverses<Rational64>();
+    inverses<BigRational>();
+    return test::result();
+}
@@ -0,0 +1,65 @@
+// 005: the LU factorization and its solves give back the input
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(5);
+
+    // L with ones on the diagonal times U, as packed in factors()
+    Matrix<Rational64> unpack(const linal::LU<Rational64>& lu) {
+        size_t n = lu.size();
+        Matrix<Rational64> l(n), u(n);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != n; ++j) {
+                if (i > j)
+                    l[i][j] = lu.factors()[i][j];
+                else
+                    u[i][j] = lu.factors()[i][j];
+            }
+        for (size_t i = 0; i != n; ++i)
+            l[i][i] = 1;
+        return l * u;
+    }
+
+    void solves() {
+        for (int t = 0; t != 20; ++t) {
+            size_t n = rng() % 8 + 1;
+            Matrix<Rational64> a = test::random_matrix<Rational64>(n, n, 4, rng);
+            linal::LU<Rational64> lu(a);
+            CHECK(lu.det() == a.det_by_definition());
+            if (lu.is_singular())
+                continue;
+            CHECK(test::equal(Matrix<Rational64>(lu.permutation_matrix() * a), unpack(lu)));
+            Matrix<Rational64> id = Matrix<Rational64>(n) ^ 0;
+            CHECK(test::equal(a * lu.inverse(), id));
+            Matrix<Rational64> b = test::random_matrix<Rational64>(n, 3, 9, rng);
+            CHECK(test::equal(a * lu.solve_many(b), b));
+            vector<Rational64> v(n);
+            for (size_t i = 0; i != n; ++i)
+                v[i] = b[i][0];
+            vector<Rational64> x = lu.solve(v);
+            for (size_t i = 0; i != n; ++i) {
+                Rational64 sum = 0;
+                for (size_t j = 0; j != n; ++j)
+                    sum += a[i][j] * x[j];
+                CHECK(sum == v[i]);
+            }
+        }
+        linal::LU<Rational64> singular(test::low_rank_matrix<Rational64>(5, 5, 3, rng));
+        CHECK(singular.is_singular() && singular.det() == Rational64(0));
+        bool thrown = false;
+        try {
+            singular.solve(vector<Rational64>(5));
+        } catch (const domain_error&) {
+            thrown = true;
+        }
+        CHECK(thrown);
+    }
+}
+
+int main() {
+    solves();
+    return test::result();
+}
@@ -0,0 +1,91 @@
+// 010: ModInt elimination, the shared prime list and the multi-modular drivers
+// against exact fractions
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(10);
+
+    Matrix<BigRational> exact(const Matrix<long long>& a) {
+        Matrix<BigRational> ans(a.size().first, a.size().second);
+        for (int i = 0; i != a.size().first; ++i)
+            for (int j = 0; j != a.size().second; ++j)
+                ans[i][j] = BigRational(BigInt(a[i][j]));
+        return ans;
+    }
+
+    void modint() {
+        const uint32_t P = 998244353;
+        for (size_t n = 1; n != 9; ++n) {
+            Matrix<long long> a = test::random_matrix<long long>(n, n, 50, rng);
+            Matrix<ModInt<P>> r(n, n);
+            Matrix<BigInt> b(n, n);
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != n; ++j)
+                    r[i][j] = ModInt<P>(a[i][j]), b[i][j] = BigInt(a[i][j]);
+            CHECK(r.det() == ModInt<P>(static_cast<long long>(b.det() % BigInt(P))));
+        }
+    }
+
+    // threads that grow the shared list at once must each see a prefix of the
+    // same sequence of primes
+    void concurrent_primes() {
+        vector<uint32_t> expected;
+        for (uint32_t p = (1u << 31) - 1; expected.size() != 400; p -= 2)
+            if (is_prime(p))
+                expected.push_back(p);
+        vector<int> ok(8);
+        vector<thread> threads;
+        for (size_t k = 0; k != ok.size(); ++k)
+            threads.emplace_back([&ok, &expected, k] {
+                bool good = true;
+                for (size_t count = k + 1; count <= expected.size(); count += ok.size()) {
+                    vector<uint32_t> p = linal::multimodular_detail::primes(count);
+                    good = good && equal(p.begin(), p.end(), expected.begin(), expected.begin() + count);
+                }
+                ok[k] = good;
+            });
+        for (thread& t : threads)
+            t.join();
+        for (int good : ok)
+            CHECK(good);
+    }
+
+    // a minor divisible by the first primes must not lose rank
+    void adversarial_rank() {
+        vector<uint32_t> p = linal::multimodular_detail::primes(4);
+        BigInt product = BigInt(p[0]) * BigInt(p[1]) * BigInt(p[2]);
+        Matrix<BigInt> a(vector<vector<BigInt>>{{BigInt(1), BigInt(2), BigInt(3)},
+                                                {BigInt(2), BigInt(4), BigInt(6) + product}});
+        CHECK(linal::multimodular_rk(a) == 2);
+        CHECK(linal::multimodular_rk(a, linal::execution::par(4)) == 2);
+        Matrix<BigInt> b(vector<vector<BigInt>>{{product * BigInt(p[3]), BigInt(0)}, {BigInt(0), product}});
+        CHECK(linal::multimodular_rk(b) == 2);
+        CHECK(linal::multimodular_det(b) == product * product * BigInt(p[3]));
+    }
+
+    void drivers(const linal::ExecutionPolicy& policy) {
+        for (int t = 0; t != 10; ++t) {
+            size_t n = rng() % 12 + 1, m = rng() % 12 + 1, r = rng() % 8 + 1;
+            Matrix<long long> a = t % 2 ? test::random_matrix<long long>(n, m, 1000, rng)
+                                        : test::low_rank_matrix<long long>(n, m, r, rng);
+            Matrix<BigRational> q = exact(a);
+            CHECK(linal::multimodular_rk(a, policy) == q.rk());
+            CHECK(test::equal(linal::multimodular_gauss(a, policy), q.gauss()));
+            CHECK(test::equal(linal::multimodular_ker(a, policy), q.ker()));
+            if (n == m)
+                CHECK(BigRational(linal::multimodular_det(a, policy)) == q.det());
+        }
+    }
+}
+
+int main() {
+    modint();
+    concurrent_primes();
+    adversarial_rank();
+    drivers(linal::execution::seq);
+    drivers(linal::execution::par(4));
+    return test::result();
+}
@@ -0,0 +1,37 @@
+// 025: permutation matrices and in-place line permutations against their dense form
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(25);
+
+    void permutation_matrices() {
+        for (int t = 0; t != 20; ++t) {
+            size_t n = rng() % 12 + 1, m = rng() % 12 + 1;
+            Matrix<long long> a = test::random_matrix<long long>(n, m, 9, rng);
+            linal::PermutationMatrix p(test::random_permutation(n, rng)), q(test::random_permutation(m, rng));
+            Matrix<long long> dp(p), dq(q);
+            CHECK(test::equal(p * a, dp * a));
+            CHECK(test::equal(p * Matrix<long long>(a), dp * a));
+            CHECK(test::equal(a * q, a * dq));
+            CHECK(test::equal(Matrix<long long>(a) * q, a * dq));
+            Matrix<long long> b = a;
+            b.permute_cols(q.permutation());
+            CHECK(test::equal(b, a * Matrix<long long>(q.transpose())));
+            CHECK(p.det() == dp.det());
+            b = a;
+            b.permute_rows(p.permutation());
+            CHECK(test::equal(b, dp * a));
+            linal::PermutationMatrix r(test::random_permutation(n, rng));
+            CHECK(test::equal(Matrix<long long>(p * r), dp * Matrix<long long>(r)));
+            CHECK(test::equal(Matrix<long long>(p.transpose()) * dp, Matrix<long long>(n) ^ 0));
+        }
+    }
+}
+
+int main() {
+    permutation_matrices();
+    return test::result();
+}
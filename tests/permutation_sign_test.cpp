@@ -0,0 +1,59 @@
+// 023: cycle-based sign and Heap's enumeration against inversion counting
+
+#include "check.h"
+
+namespace {
+    mt19937 rng(23);
+
+    int inversion_sign(const Permutation& p) {
+        int sign = 1;
+        for (size_t i = 0; i != p.size(); ++i)
+            for (size_t j = i + 1; j != p.size(); ++j)
+                if (p[i] > p[j])
+                    sign = -sign;
+        return sign;
+    }
+
+    void sign_and_cycles() {
+        for (int t = 0; t != 300; ++t) {
+            Permutation p = test::random_permutation(rng() % 40, rng);
+            CHECK(p.sign() == inversion_sign(p));
+            size_t total = 0;
+            for (const vector<int>& c : p.cycles()) {
+                total += c.size();
+                for (size_t k = 0; k != c.size(); ++k)
+                    CHECK(p[c[k]] == c[(k + 1) % c.size()]);
+            }
+            CHECK(total == p.size());
+        }
+    }
+
+    void enumeration() {
+        for (size_t n = 0; n != 8; ++n) {
+            PermutationEnumerator e(n);
+            set<vector<int>> seen;
+            do {
+                const Permutation& p = e.permutation();
+                vector<int> v(n);
+                for (size_t i = 0; i != n; ++i)
+                    v[i] = p[i];
+                seen.insert(v);
+                CHECK(e.sign() == inversion_sign(p));
+            } while (e.next());
+            size_t factorial = 1;
+            for (size_t k = 2; k <= n; ++k)
+                factorial *= k;
+            CHECK(seen.size() == factorial);
+        }
+        for (size_t n = 0; n != 8; ++n) {
+            linal::Matrix<long long> a = test::random_matrix<long long>(n, n, 5, rng);
+            CHECK(a.det_by_definition() == a.det_bareiss());
+        }
+    }
+}
+
+int main() {
+    sign_and_cycles();
+    enumeration();
+    return test::result();
+}
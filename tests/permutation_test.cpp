@@ -0,0 +1,58 @@
+// 024: the in-place and cycle-form permutation algebra against plain products
+
+#include "check.h"
+
+namespace {
+    mt19937 rng(24);
+
+    Permutation inverse(const Permutation& p) {
+        Permutation ans(p.size());
+        for (size_t i = 0; i != p.size(); ++i)
+            ans[p[i]] = i;
+        return ans;
+    }
+
+    // one product at a time
+    Permutation slow_power(const Permutation& p, long long pow) {
+        Permutation ans(p.size()), base = pow < 0 ? inverse(p) : p;
+        for (long long k = 0; k != (pow < 0 ? -pow : pow); ++k)
+            ans = ans * base;
+        return ans;
+    }
+
+    void algebra() {
+        for (int t = 0; t != 200; ++t) {
+            size_t n = rng() % 30;
+            Permutation p = test::random_permutation(n, rng), q = test::random_permutation(n, rng);
+            for (long long k = -20; k <= 20; ++k)
+                CHECK((p ^ k) == slow_power(p, k));
+            Permutation into(7);
+            p.compose_into(q, into);
+            CHECK(into.size() == n && into == p * q);
+            p.inverse_into(into);
+            CHECK(into == inverse(p));
+            Permutation r = p;
+            r.invert();
+            CHECK(r == inverse(p));
+            // *= composes in place, also when the operand is the permutation itself
+            Permutation s = p;
+            s *= q;
+            CHECK(s == p * q);
+            s = p;
+            s *= s;
+            CHECK(s == p * p);
+        }
+        // long permutations square and multiply small powers instead of following cycles
+        size_t n = 300000;
+        Permutation p = test::random_permutation(n, rng);
+        for (long long k : {0LL, 1LL, 2LL, 7LL, 31LL, 32LL, -2LL, -31LL, 1000000007LL})
+            CHECK((p ^ k) == ((p ^ (k - 1)) * p));
+        Permutation back = p ^ -1000000007LL;
+        CHECK((back * (p ^ 1000000007LL)) == Permutation(n));
+    }
+}
+
+int main() {
+    algebra();
+    return test::result();
+}
@@ -0,0 +1,39 @@
+// 014: coefficient writes keep the polynomial free of leading zeroes
+
+#include "check.h"
+
+namespace {
+    void coefficients() {
+        Polynomial<long long> p;
+        p.set(3, 5);
+        CHECK(p.Degree() == 3 && p.get().size() == 4);
+        p.set(7, 0);
+        CHECK(p.Degree() == 3);
+        p[1] = 2;
+        CHECK(p.Degree() == 3 && p.get()[1] == 2);
+        p.set(3, 0);
+        CHECK(p.Degree() == 1);
+        bool thrown = false;
+        try {
+            p[5] = 1;
+        } catch (const out_of_range&) {
+            thrown = true;
+        }
+        CHECK(thrown && p.Degree() == 1);
+        const Polynomial<long long>& view = p;
+        CHECK(view[5] == 0);
+
+        Polynomial<long long> q;
+        q += 4;
+        CHECK(q.Degree() == 0 && q.get()[0] == 4);
+        q -= 4;
+        CHECK(q.Degree() == -1 && q == Polynomial<long long>());
+        q -= 3;
+        CHECK(q.Degree() == 0 && q.get()[0] == -3);
+    }
+}
+
+int main() {
+    coefficients();
+    return test::result();
+}
@@ -0,0 +1,118 @@
+// 008 and 009: the mixed operators, lazily normalized fractions and the binary
+// gcd kernel against Euclid
+
+#include "check.h"
+
+namespace {
+    mt19937_64 rng(9);
+
+    template <typename A, typename B, typename = void>
+    struct addable : std::false_type {};
+
+    template <typename A, typename B>
+    struct addable<A, B, decltype(void(std::declval<A>() + std::declval<B>()))> : std::true_type {};
+
+    // a floating operand would be truncated to the integer type, so it does not compile
+    static_assert(addable<Rational64, int>::value && addable<long long, Rational64>::value, "");
+    static_assert(addable<BigRational, BigInt>::value && addable<BigRational, int>::value, "");
+    static_assert(!addable<Rational64, double>::value && !addable<float, Rational64>::value, "");
+    static_assert(!addable<BigRational, double>::value, "");
+
+    void mixed_operators() {
+        CHECK(Rational64(1, 3) + 1 == Rational64(4, 3));
+        CHECK(2LL * Rational64(1, 4) == Rational64(1, 2));
+        CHECK(BigRational(BigInt(1), BigInt(3)) - BigInt(1) == BigRational(BigInt(-2), BigInt(3)));
+    }
+
+    template <typename F>
+    bool overflows(F f) {
+        try {
+            f();
+        } catch (const overflow_error&) {
+            return true;
+        }
+        return false;
+    }
+
+    // built-in integers wider than the backend are range-checked, not cut
+    void narrowing() {
+        const long long big = 1LL << 40;
+        CHECK(overflows([&] { return Rational(big); }));
+        CHECK(overflows([&] { return Rational(big, 3); }));
+        CHECK(overflows([&] { return Rational(1, 3) + big; }));
+        CHECK(overflows([&] { return big * Rational(1, 3); }));
+        CHECK(overflows([&] { return Rational(Rational64(big)); }));
+        CHECK(!(Rational(1, 3) == big) && Rational(1) != big);
+        CHECK(Rational(1LL << 20) == (1 << 20) && Rational(6LL, 4LL) == Rational(3, 2));
+        CHECK(Rational64(big) + Rational64(1, 3) == Rational64(3 * big + 1, 3));
+        CHECK(Rational128(big) * big == Rational128(__int128(big) * big));
+        CHECK(BigRational(big) == BigRational(BigInt(big)));
+    }
+
+    bool same(const LazyRational64& x, const BigRational& y) {
+        LazyRational64 r = x.reduced();
+        return BigRational(BigInt(r.numerator()), BigInt(r.denominator())) == y;
+    }
+
+    // lazy values postpone the gcd until a product would overflow, the value stays the same
+    void lazy() {
+        LazyRational64 sum = 0;
+        BigRational exact = 0;
+        for (int k = 1; k <= 30; ++k) {
+            sum += LazyRational64(1, k);
+            exact += BigRational(1, k);
+            CHECK(same(sum, exact));
+        }
+        mt19937 small(9);
+        for (int t = 0; t != 2000; ++t) {
+            LazyRational64 x = 0;
+            BigRational y = 0;
+            for (int k = 0; k != 12; ++k) {
+                int p = int(small() % 19) - 9, q = int(small() % 9) + 1;
+                switch (small() % 4) {
+                    case 0: x = x + LazyRational64(p, q), y = y + BigRational(p, q); break;
+                    case 1: x = x - LazyRational64(p, q), y = y - BigRational(p, q); break;
+                    case 2: x = x * LazyRational64(p, q), y = y * BigRational(p, q); break;
+                    default:
+                        if (p != 0)
+                            x = x / LazyRational64(p, q), y = y / BigRational(p, q);
+                }
+            }
+            CHECK(same(x, y));
+            CHECK((x == LazyRational64(0)) == (y == BigRational(0)));
+        }
+        linal::Matrix<LazyRational64> a(6);
+        linal::Matrix<Rational64> b(6);
+        for (size_t i = 0; i != 6; ++i)
+            for (size_t j = 0; j != 6; ++j) {
+                int p = int(small() % 19) - 9, q = int(small() % 5) + 1;
+                a[i][j] = LazyRational64(p, q), b[i][j] = Rational64(p, q);
+            }
+        Rational64 det = b.det();
+        CHECK(same(a.det(), BigRational(BigInt(det.numerator()), BigInt(det.denominator()))));
+    }
+
+    template <typename Int>
+    void gcd_kernel() {
+        for (int t = 0; t != 200000; ++t) {
+            // shared powers of two and equal operands are the edge cases of the loop
+            Int a = Int(rng() >> (rng() % 56 + 8)) << (t % 5), b = t % 7 ? Int(rng() >> (rng() % 56 + 8)) << (t % 3) : a;
+            if (t % 2)
+                a = -a;
+            CHECK(::gcd_kernel(a, b) == gcd_euclid(a, b));
+        }
+        CHECK(::gcd_kernel(Int(0), Int(0)) == 0);
+        CHECK(::gcd_kernel(Int(12), Int(0)) == 12);
+        CHECK(::gcd_kernel(Int(0), Int(-12)) == 12);
+        CHECK(::gcd_kernel(Int(48), Int(48)) == 48);
+    }
+}
+
+int main() {
+    mixed_operators();
+    narrowing();
+    lazy();
+    gcd_kernel<long long>();
+    gcd_kernel<__int128>();
+    return test::result();
+}
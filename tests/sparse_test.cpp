@@ -0,0 +1,115 @@
+// 015: SparseMatrix products and Markowitz elimination against the dense Matrix
+
+#include "check.h"
+
+using linal::Matrix;
+using linal::SparseMatrix;
+
+namespace {
+    mt19937 rng(15);
+
+    // about one entry in density is nonzero
+    template <typename T>
+    Matrix<T> sparse_random(size_t n, size_t m, size_t density) {
+        Matrix<T> a(n, m);
+        for (size_t i = 0; i != n; ++i)
+            for (size_t j = 0; j != m; ++j)
+                if (rng() % density == 0)
+                    a[i][j] = T(int(rng() % 19) - 9);
+        return a;
+    }
+
+    void products() {
+        for (int t = 0; t != 20; ++t) {
+            size_t n = rng() % 40 + 1, k = rng() % 40 + 1, m = rng() % 40 + 1;
+            Matrix<long long> a = sparse_random<long long>(n, k, 4), b = sparse_random<long long>(k, m, 4);
+            SparseMatrix<long long> x(a), y(b);
+            CHECK(test::equal(x.to_dense(), a));
+            CHECK(test::equal(x.transpose().to_dense(), Matrix<long long>(a.transpose())));
+            CHECK(test::equal((x * y).to_dense(), test::naive_product(a, b)));
+            CHECK(test::equal(x.multiply(y, linal::execution::par(4)).to_dense(), test::naive_product(a, b)));
+            vector<long long> v(k);
+            for (long long& c : v)
+                c = int(rng() % 19) - 9;
+            vector<long long> w = x * v;
+            for (size_t i = 0; i != n; ++i) {
+                long long sum = 0;
+                for (size_t j = 0; j != k; ++j)
+                    sum += a[i][j] * v[j];
+                CHECK(w[i] == sum);
+            }
+        }
+    }
+
+    // Markowitz order picks other pivots than Gauss, so kernels are compared by
+    // dimension and by being annihilated
+    void elimination() {
+        for (int t = 0; t != 30; ++t) {
+            size_t n = rng() % 20 + 1, m = rng() % 20 + 1;
+            Matrix<BigRational> a = t % 3 ? sparse_random<BigRational>(n, m, 3)
+                                          : test::low_rank_matrix<BigRational>(n, m, rng() % 5 + 1, rng);
+            SparseMatrix<BigRational> s(a);
+            size_t rank = a.rk();
+            CHECK(s.rk() == rank);
+            Matrix<BigRational> k = s.ker().to_dense();
+            CHECK(k.size().second == int(m - rank));
+            CHECK(test::equal(a * k, Matrix<BigRational>(n, k.size().second)));
+            CHECK(k.rk() == size_t(k.size().second));
+        }
+    }
+
+    // shapes where the cheapest pivot is not in the shortest column: an arrowhead, whose
+    // dense corner would fill everything in, and short columns that only meet long lines
+    void structured_elimination() {
+        size_t n = 120;
+        Matrix<Rational64> arrow(n, n);
+        for (size_t i = 0; i != n; ++i)
+            arrow[i][i] = Rational64(int(i % 7) + 2), arrow[0][i] = arrow[i][0] = Rational64(1);
+        SparseMatrix<Rational64> s(arrow);
+        CHECK(s.rk() == arrow.rk());
+        CHECK(s.ker().size().second == int(n - arrow.rk()));
+        for (int t = 0; t != 20; ++t) {
+            size_t lines = rng() % 20 + 4, columns = rng() % 20 + 4;
+            Matrix<BigRational> a = sparse_random<BigRational>(lines, columns, 5);
+            for (size_t j = 0; j != columns; ++j)
+                a[rng() % 2][j] = BigRational(int(rng() % 9) + 1);
+            SparseMatrix<BigRational> x(a);
+            size_t rank = a.rk();
+            CHECK(x.rk() == rank);
+            Matrix<BigRational> k = x.ker().to_dense();
+            CHECK(k.size().second == int(columns - rank));
+            CHECK(test::equal(a * k, Matrix<BigRational>(lines, k.size().second)));
+        }
+    }
+
+    // floating fill-in that cancels up to rounding must not become a pivot, so
+    // the rank agrees with the dense tolerance
+    void floating_elimination() {
+        auto agree = [](const Matrix<double>& a) {
+            SparseMatrix<double> s(a);
+            size_t rank = a.rk();
+            CHECK(s.rk() == rank);
+            Matrix<double> k = s.ker().to_dense();
+            CHECK(k.size().second == int(a.size().second - rank));
+            CHECK(test::close(a * k, Matrix<double>(a.size().first, k.size().second), 1e-9));
+        };
+        agree(Matrix<double>(vector<vector<double>>{{.1, .2, .3}, {.3, .6, .9}, {.7, .1, .5}}));
+        agree(Matrix<double>(vector<vector<double>>{{.1, .7, .3}, {.3, 2.1, .9}, {.2, 1.4, .6}}));
+        for (int t = 0; t != 30; ++t) {
+            size_t n = rng() % 30 + 1, m = rng() % 30 + 1, r = rng() % 5 + 1;
+            Matrix<double> a = test::low_rank_matrix<double>(n, m, r, rng);
+            for (size_t i = 0; i != n; ++i)
+                for (size_t j = 0; j != m; ++j)
+                    a[i][j] /= 10;
+            agree(a);
+        }
+    }
+}
+
+int main() {
+    products();
+    elimination();
+    structured_elimination();
+    floating_elimination();
+    return test::result();
+}
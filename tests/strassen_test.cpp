@@ -0,0 +1,30 @@
+// 020: Strassen-Winograd products of fractions and big integers against the naive loop
+
+#include "check.h"
+
+using linal::Matrix;
+
+namespace {
+    mt19937 rng(20);
+
+    // a small cutover makes small matrices recurse several levels, odd sizes included
+    template <typename T>
+    void products(size_t cutover) {
+        size_t saved = linal::strassen::cutover;
+        linal::strassen::cutover = cutover;
+        for (int t = 0; t != 5; ++t) {
+            size_t n = rng() % 30 + 5, k = rng() % 30 + 5, m = rng() % 30 + 5;
+            Matrix<T> a = test::random_matrix<T>(n, k, 3, rng), b = test::random_matrix<T>(k, m, 3, rng);
+            CHECK(test::equal(a * b, test::naive_product(a, b)));
+        }
+        linal::strassen::cutover = saved;
+    }
+}
+
+int main() {
+    products<Rational64>(4);
+    products<Rational64>(1);
+    products<BigInt>(4);
+    products<BigRational>(7);
+    return test::result();
+}
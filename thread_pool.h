@@ -0,0 +1,186 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace linal {
+    // Work-stealing pool: every worker owns a deque, takes its own tasks from
+    // the back and steals from the front of the others when it runs dry.
+    class ThreadPool {
+      private:
+        struct Queue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;     // queues[0] is shared by outside threads
+        std::vector<std::thread> workers;
+        std::atomic<size_t> pending{0};
+        std::atomic<bool> stop{false};
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+
+        // index of the queue owned by this thread, 0 for threads outside the pool
+        size_t& own_queue() const {
+            thread_local std::map<const ThreadPool*, size_t> index;
+            return index[this];
+        }
+
+        bool pop(size_t q, bool back, std::function<void()>& task) {
+            std::lock_guard<std::mutex> guard(queues[q] -> lock);
+            if (queues[q] -> tasks.empty())
+                return false;
+            if (back) {
+                task = std::move(queues[q] -> tasks.back());
+                queues[q] -> tasks.pop_back();
+            } else {
+                task = std::move(queues[q] -> tasks.front());
+                queues[q] -> tasks.pop_front();
+            }
+            --pending;
+            return true;
+        }
+
+        void work(size_t q) {
+            own_queue() = q;
+            while (!stop) {
+                if (run_one())
+                    continue;
+                std::unique_lock<std::mutex> guard(sleep_lock);
+                wake.wait(guard, [this] { return stop || pending > 0; });
+            }
+        }
+
+      public:
+        // the calling thread also runs tasks while it waits, so threads - 1 workers are started
+        explicit ThreadPool(size_t threads) {
+            threads = std::max<size_t>(threads, 1);
+            for (size_t i = 0; i != threads; ++i)
+                queues.emplace_back(new Queue());
+            for (size_t i = 1; i != threads; ++i)
+                workers.emplace_back(&ThreadPool::work, this, i);
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        ~ThreadPool() {
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                stop = true;
+            }
+            wake.notify_all();
+            for (std::thread& t : workers)
+                t.join();
+        }
+
+        size_t size() const {
+            return queues.size();
+        }
+
+        void submit(std::function<void()> task) {
+            size_t q = own_queue();
+            {
+                std::lock_guard<std::mutex> guard(queues[q] -> lock);
+                queues[q] -> tasks.push_back(std::move(task));
+            }
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                ++pending;
+            }
+            wake.notify_one();
+        }
+
+        // runs one task from the own queue or a stolen one, false if there was nothing to do
+        bool run_one() {
+            std::function<void()> task;
+            size_t q = own_queue();
+            bool found = pop(q, true, task);
+            for (size_t i = 1; !found && i != queues.size(); ++i)
+                found = pop((q + i) % queues.size(), false, task);
+            if (found)
+                task();
+            return found;
+        }
+
+        // calls f(l, r) on pieces of [begin, end) of at most grain elements and waits for all of them;
+        // pieces are split off in halves, so idle workers steal big ranges first
+        template <typename F>
+        void parallel_for(size_t begin, size_t end, size_t grain, const F& f) {
+            if (begin >= end)
+                return;
+            grain = std::max<size_t>(grain, 1);
+            std::atomic<size_t> done{0};
+            std::exception_ptr error;
+            std::mutex error_lock;
+            std::function<void(size_t, size_t)> run = [&](size_t l, size_t r) {
+                while (r - l > grain) {
+                    size_t mid = l + (r - l + grain - 1) / grain / 2 * grain;
+                    submit([&run, mid, r] { run(mid, r); });
+                    r = mid;
+                }
+                try {
+                    f(l, r);
+                } catch (...) {
+                    std::lock_guard<std::mutex> guard(error_lock);
+                    if (!error)
+                        error = std::current_exception();
+                }
+                done += r - l;
+            };
+            run(begin, end);
+            while (done != end - begin)
+                if (!run_one())
+                    std::this_thread::yield();
+            if (error)
+                std::rethrow_exception(error);
+        }
+
+        // process-wide pool with exactly this many threads, created on first use
+        static ThreadPool& shared(size_t threads) {
+            static std::mutex lock;
+            static std::map<size_t, std::unique_ptr<ThreadPool>> pools;
+            std::lock_guard<std::mutex> guard(lock);
+            std::unique_ptr<ThreadPool>& pool = pools[threads];
+            if (!pool)
+                pool.reset(new ThreadPool(threads));
+            return *pool;
+        }
+    };
+
+    // how many threads an operation may use
+    struct ExecutionPolicy {
+        size_t threads;
+    };
+
+    namespace execution {
+        const ExecutionPolicy seq{1};
+
+        // threads = 0 means one per hardware thread
+        inline ExecutionPolicy par(size_t threads = 0) {
+            if (threads == 0)
+                threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+            return {threads};
+        }
+    }
+
+    // f(l, r) over pieces of [begin, end), inline for a single thread
+    template <typename F>
+    void parallel_for(const ExecutionPolicy& policy, size_t begin, size_t end, size_t grain, const F& f) {
+        if (policy.threads <= 1 || end - begin <= grain) {
+            if (begin < end)
+                f(begin, end);
+            return;
+        }
+        ThreadPool::shared(policy.threads).parallel_for(begin, end, grain, f);
+    }
+}